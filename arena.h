@@ -0,0 +1,41 @@
+/*
+ * File: arena.h
+ * Author: Edward Fattell
+ * Purpose: Bump-pointer arena.  Allocations are carved from large blocks and
+ *          are never freed one at a time; the whole arena is reset or freed
+ *          at once.
+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+struct arena {
+  struct arenablock *first; /* blocks, in the order they are used */
+  struct arenablock *cur;   /* block being allocated from */
+  char *next;               /* next free byte of cur */
+  char *end;                /* end of cur */
+} typedef Arena;
+
+/*
+ * arena_init() prepares an empty arena; arena_free() releases its blocks,
+ * after which nothing allocated from it may be used.
+ */
+void arena_init(Arena *arena);
+void arena_free(Arena *arena);
+
+/*
+ * arena_alloc() returns size bytes aligned for a pointer, which suits the
+ * structs the compiler allocates but not long double or vector types.  The
+ * memory is not cleared.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/*
+ * arena_reset() makes every block free again in constant time.  The blocks
+ * are kept and reused by later allocations.
+ */
+void arena_reset(Arena *arena);
+
+#endif /* __ARENA_H__ */
@@ -8,9 +8,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "ast.h"
+#include "ast-walk.h"
 
 char *opname(NodeType ntype);
-static void print_ast_formatted(void *tree, int n, int nl);
+static int print_step(AstWalk *walk, AstFrame *frame);
 
 /*
  * print_ast(tree) takes a pointer to an AST node and uses the getter
@@ -18,7 +19,11 @@ static void print_ast_formatted(void *tree, int n, int nl);
  * that node.
  */
 void print_ast(void *tree) {
-  print_ast_formatted(tree, 0, 1);
+  AstWalk walk;
+
+  ast_walk_init(&walk, print_step, NULL);
+  ast_walk(&walk, tree, 0, 1);
+  ast_walk_free(&walk);
 }
 
 
@@ -39,28 +44,30 @@ static void indent(int n) {
 #define SPACES_PER_INDENTATION_LEVEL  4
 
 /*
- * print_ast_formatted(tree, n) takes a pointer to an AST node and uses the 
- * getter functions supplied by the user to traverse and print the tree.  The
- * second argument specifies a left-indentation level.  The third argument
- * specifies whether a newline should be printed at the end.
+ * print_step(walk, frame) prints one step of the node in frame and pushes the
+ * child to be printed next.  frame->arg0 is the left-indentation level and
+ * frame->arg1 says whether a newline should be printed at the end.
  */
-static void print_ast_formatted(void *tree, int n, int nl) {
+static int print_step(AstWalk *walk, AstFrame *frame) {
+  void *tree = frame->node;
+  int n = frame->arg0;
+  int nl = frame->arg1;
   NodeType ntype;
   char *name;
-  void *list_hd, *list_tl;
+  void *list_tl;
   int i, nargs;
 
   int indent_amt = n * SPACES_PER_INDENTATION_LEVEL;
 
-  if (tree == NULL) {
-    return;
-  }
-
   ntype = ast_node_type(tree);
-  
+
   switch (ntype) {
   case FUNC_DEF:
     name = func_def_name(tree);
+    if (frame->step == 1) {
+      printf("/* func_def: %s */\n\n", name);
+      return 0;
+    }
     printf("func_def: %s\n", name);  /* print the function's name */
 
     printf("  formals: ");           /* print the function's formals */
@@ -71,90 +78,123 @@ static void print_ast_formatted(void *tree, int n, int nl) {
     }
 
     printf("\n  body:\n");           /* print the function's body */
-    print_ast_formatted(func_def_body(tree), n+1, 1);
-    printf("/* func_def: %s */\n\n", name);
-    break;
+    ast_walk_push(walk, func_def_body(tree), n+1, 1);
+    return 1;
 
   case FUNC_CALL:
+    if (frame->step == 1) {
+      printf(")");
+      if (nl != 0) {
+        printf("\n");
+      }
+      return 0;
+    }
     indent(indent_amt);
     name = func_call_callee(tree);
     printf("%s(", name);  /* print the callee's name */
-    print_ast_formatted(func_call_args(tree), 0, 0);   /* print the argument list */
-    printf(")");
-    if (nl != 0) {
-      printf("\n");
-    }
-    break;
+    ast_walk_push(walk, func_call_args(tree), 0, 0);   /* print the argument list */
+    return 1;
 
   case STMT_LIST:
-    indent(indent_amt);
-    printf("{\n");
-    while (tree != NULL) {
-      list_hd = stmt_list_head(tree);
-      tree = stmt_list_rest(tree);
-      print_ast_formatted(list_hd, n+1, nl);
+    /* aux is the rest of the list still to be printed */
+    if (frame->step == 0) {
+      indent(indent_amt);
+      printf("{\n");
+      frame->aux = tree;
+    }
+    if (frame->aux != NULL) {
+      void *list_hd = stmt_list_head(frame->aux);
+      frame->aux = stmt_list_rest(frame->aux);
+      ast_walk_push(walk, list_hd, n+1, nl);
+      return 1;
     }
     indent(indent_amt);
     printf("}\n");
-    break;
+    return 0;
 
   case IF:
-    indent(indent_amt); printf("if (");
-    print_ast_formatted(stmt_if_expr(tree), 0, 0);
-    printf("):\n");
-    indent(indent_amt); printf("then:\n");
-    print_ast_formatted(stmt_if_then(tree), n+1, nl);
-    indent(indent_amt); printf("else:\n");
-    print_ast_formatted(stmt_if_else(tree), n+1, nl);
+    switch (frame->step) {
+    case 0:
+      indent(indent_amt); printf("if (");
+      ast_walk_push(walk, stmt_if_expr(tree), 0, 0);
+      return 1;
+    case 1:
+      printf("):\n");
+      indent(indent_amt); printf("then:\n");
+      ast_walk_push(walk, stmt_if_then(tree), n+1, nl);
+      return 1;
+    case 2:
+      indent(indent_amt); printf("else:\n");
+      ast_walk_push(walk, stmt_if_else(tree), n+1, nl);
+      return 1;
+    }
     indent(indent_amt);
     printf("end_if\n");
-    break;
+    return 0;
 
   case ASSG:
+    if (frame->step == 1) {
+      printf("\n");
+      return 0;
+    }
     indent(indent_amt);
     printf("%s = ", stmt_assg_lhs(tree));
-    print_ast_formatted(stmt_assg_rhs(tree), 0, 0);
-    printf("\n");
-    break;
+    ast_walk_push(walk, stmt_assg_rhs(tree), 0, 0);
+    return 1;
 
   case WHILE:
-    indent(indent_amt); printf("while (");
-    print_ast_formatted(stmt_while_expr(tree), 0, 0);
-    printf("):\n");
-    print_ast_formatted(stmt_while_body(tree), n+1, 1);
+    switch (frame->step) {
+    case 0:
+      indent(indent_amt); printf("while (");
+      ast_walk_push(walk, stmt_while_expr(tree), 0, 0);
+      return 1;
+    case 1:
+      printf("):\n");
+      ast_walk_push(walk, stmt_while_body(tree), n+1, 1);
+      return 1;
+    }
     indent(indent_amt);
     printf("end_while\n");
-    break;
+    return 0;
 
   case RETURN:
+    if (frame->step == 1) {
+      printf("\n");
+      return 0;
+    }
     indent(indent_amt);
     printf("return: ");
-    print_ast_formatted(stmt_return_expr(tree), 0, 0);
-    printf("\n");
-    break;
+    ast_walk_push(walk, stmt_return_expr(tree), 0, 0);
+    return 1;
 
   case EXPR_LIST:
+    if (frame->step == 0) {
+      ast_walk_push(walk, expr_list_head(tree), 0, 0);
+      return 1;
+    }
     list_tl = expr_list_rest(tree);
-    print_ast_formatted(expr_list_head(tree), 0, 0);
     if (list_tl != NULL) {
       printf(", ");
     }
-    print_ast_formatted(list_tl, 0, 0);
-    break;
+    ast_walk_push(walk, list_tl, 0, 0);
+    return 0;
 
   case IDENTIFIER:
     printf("%s", expr_id_name(tree));
-    break;
+    return 0;
 
   case INTCONST:
     printf("%d", expr_intconst_val(tree));
-    break;
+    return 0;
     
   case UMINUS:
+    if (frame->step == 1) {
+      printf(")");
+      return 0;
+    }
     printf("-(");
-    print_ast_formatted(expr_operand_1(tree), 0, 0);
-    printf(")");
-    break;
+    ast_walk_push(walk, expr_operand_1(tree), 0, 0);
+    return 1;
 
   case EQ:
   case NE:
@@ -162,34 +202,41 @@ static void print_ast_formatted(void *tree, int n, int nl) {
   case LT:
   case GE:
   case GT:
-    print_ast_formatted(expr_operand_1(tree), 0, 0);
+    if (frame->step == 0) {
+      ast_walk_push(walk, expr_operand_1(tree), 0, 0);
+      return 1;
+    }
     printf(" %s ", opname(ntype));
-    print_ast_formatted(expr_operand_2(tree), 0, 0);
-    break;
+    ast_walk_push(walk, expr_operand_2(tree), 0, 0);
+    return 0;
 
   case ADD:
   case SUB:
   case MUL:
   case DIV:
-    printf("(");
-    print_ast_formatted(expr_operand_1(tree), 0, 0);
-    printf(" %s ", opname(ntype));
-    print_ast_formatted(expr_operand_2(tree), 0, 0);
-    printf(")");
-    break;
-
   case AND:
   case OR:
-    printf("(");
-    print_ast_formatted(expr_operand_1(tree), 0, 0);
-    printf(") %s (", opname(ntype));
-    print_ast_formatted(expr_operand_2(tree), 0, 0);
+    switch (frame->step) {
+    case 0:
+      printf("(");
+      ast_walk_push(walk, expr_operand_1(tree), 0, 0);
+      return 1;
+    case 1:
+      if (ntype == AND || ntype == OR) {
+        printf(") %s (", opname(ntype));
+      } else {
+        printf(" %s ", opname(ntype));
+      }
+      ast_walk_push(walk, expr_operand_2(tree), 0, 0);
+      return 1;
+    }
     printf(")");
-    break;
+    return 0;
 
   default:
     fprintf(stderr, "*** [%s] Unrecognized syntax tree node type %d\n",
 	    __func__, ntype);
+    return 0;
   }
 }
 
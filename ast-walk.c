@@ -0,0 +1,62 @@
+/*
+ * Author: Edward Fattell
+ * File: ast-walk.c
+ * Purpose: Explicit-stack tree traversal
+ */
+#include "ast-walk.h"
+#include <stdlib.h>
+#include <string.h>
+
+void ast_walk_init(AstWalk *walk, AstVisit visit, void *ctx) {
+  walk->cap = 64;
+  walk->stack = malloc(sizeof(AstFrame) * walk->cap);
+  walk->depth = 0;
+  walk->visit = visit;
+  walk->ctx = ctx;
+}
+
+void ast_walk_free(AstWalk *walk) {
+  free(walk->stack);
+  walk->stack = NULL;
+  walk->depth = 0;
+  walk->cap = 0;
+}
+
+void ast_walk_push(AstWalk *walk, void *node, int arg0, int arg1) {
+  if (node == NULL) {
+    return;
+  }
+  if (walk->depth == walk->cap) {
+    walk->cap *= 2;
+    walk->stack = realloc(walk->stack, sizeof(AstFrame) * walk->cap);
+  }
+
+  AstFrame *frame = &walk->stack[walk->depth++];
+  frame->node = node;
+  frame->aux = NULL;
+  frame->step = 0;
+  frame->arg0 = arg0;
+  frame->arg1 = arg1;
+}
+
+void ast_walk(AstWalk *walk, void *root, int arg0, int arg1) {
+  int base = walk->depth;
+
+  ast_walk_push(walk, root, arg0, arg1);
+  while (walk->depth > base) {
+    int i = walk->depth - 1;
+
+    // the stack may move if the visit pushes, so go through i afterwards
+    if (walk->visit(walk, &walk->stack[i])) {
+      walk->stack[i].step++;
+      continue;
+    }
+
+    // drop the finished frame from under anything it pushed
+    int pushed = walk->depth - i - 1;
+    if (pushed > 0) {
+      memmove(&walk->stack[i], &walk->stack[i + 1], sizeof(AstFrame) * pushed);
+    }
+    walk->depth--;
+  }
+}
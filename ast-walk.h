@@ -0,0 +1,59 @@
+/*
+ * File: ast-walk.h
+ * Author: Edward Fattell
+ * Purpose: Tree traversal with an explicit stack instead of C recursion, so
+ *          the depth of the walk is bounded by the heap rather than by the C
+ *          stack.  A pass supplies a visit function that is called once per
+ *          step of each node and schedules children with ast_walk_push().
+ */
+
+#ifndef __AST_WALK_H__
+#define __AST_WALK_H__
+
+/*
+ * astframe is one node being visited.  step counts the earlier calls of the
+ * visit function for the node; aux, arg0 and arg1 belong to the pass.
+ */
+struct astframe {
+  void *node;
+  void *aux;
+  int step;
+  int arg0;
+  int arg1;
+} typedef AstFrame;
+
+struct astwalk;
+
+/*
+ * A visit function handles one step of frame->node.  Children it pushes are
+ * walked before the node's next step, the last pushed first.  It returns
+ * nonzero to be called again after them, or 0 when the node is finished; a
+ * node that finishes right after pushing is replaced by its children, so
+ * walking a right-nested list takes constant stack.  frame may only be used
+ * until the first ast_walk_push() of the call.
+ */
+typedef int (*AstVisit)(struct astwalk *walk, AstFrame *frame);
+
+struct astwalk {
+  AstFrame *stack;
+  int depth;
+  int cap;
+  AstVisit visit;
+  void *ctx; /* for the pass */
+} typedef AstWalk;
+
+void ast_walk_init(AstWalk *walk, AstVisit visit, void *ctx);
+void ast_walk_free(AstWalk *walk);
+
+/*
+ * ast_walk_push() schedules node, with the pass's arguments, to be walked
+ * next.  Pushing NULL does nothing.
+ */
+void ast_walk_push(AstWalk *walk, void *node, int arg0, int arg1);
+
+/*
+ * ast_walk() walks the tree below root and returns when it is finished.
+ */
+void ast_walk(AstWalk *walk, void *root, int arg0, int arg1);
+
+#endif /* __AST_WALK_H__ */
@@ -5,20 +5,130 @@
  */
 
 #include "ast.h"
+#include "astcompact.h"
 #include "parser.h"
 #include <assert.h>
 #include <stddef.h>
 
-NodeType ast_node_type(void *ptr) {
+/*
+ * Each getter accepts either a Quad pointer or a handle for a node of
+ * compact_tree, and reads the field it needs through one of these.
+ */
+
+/*
+ * node_child() - child 0, 1 or 2 of a node, in the same form as the node
+ */
+static void *node_child(void *ptr, int n) {
+  assert(ptr != NULL);
+  if (compact_is_handle(ptr)) {
+    uint32_t idx = compact_index(ptr);
+    uint32_t *child = n == 0   ? compact_tree.child0
+                      : n == 1 ? compact_tree.child1
+                               : compact_tree.child2;
+    return compact_handle(child[idx]);
+  }
+
   Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->type;
+  return n == 0 ? ast->child0 : n == 1 ? ast->child1 : ast->child2;
+}
+
+/*
+ * A list view stands for the elements of a list from some element on.  It is
+ * the address of that element's slot in the Quad's elems, or its position in
+ * compact_tree.elems shifted like a compact handle, tagged with VIEW_TAG and,
+ * for an expression list, VIEW_EXPR.
+ */
+#define VIEW_TAG 2
+#define VIEW_EXPR 4
+#define VIEW_BITS 7
+
+static void *make_view(uintptr_t at, NodeType type) {
+  return (void *)(at | VIEW_TAG | (type == EXPR_LIST ? VIEW_EXPR : 0));
+}
+
+/*
+ * list_head() - the first element of a list node or view, NULL if empty
+ */
+static void *list_head(void *ptr) {
+  uintptr_t h = (uintptr_t)ptr;
+  assert(ptr != NULL);
+
+  if (h & VIEW_TAG) {
+    if (compact_is_handle(ptr)) {
+      return compact_handle(compact_tree.elems[h >> 3]);
+    }
+    return *(Quad **)(h & ~(uintptr_t)VIEW_BITS);
+  }
+  if (compact_is_handle(ptr)) {
+    uint32_t pos = compact_tree.child0[compact_index(ptr)];
+    return compact_handle(compact_tree.elems[pos]);
+  }
+  return ((Quad *)ptr)->elems[0];
+}
+
+/*
+ * list_rest() - a view of the elements after the first, NULL if none
+ */
+static void *list_rest(void *ptr) {
+  uintptr_t h = (uintptr_t)ptr;
+  NodeType type = ast_node_type(ptr);
+  assert(ptr != NULL);
+
+  if (compact_is_handle(ptr)) {
+    uint32_t pos =
+        h & VIEW_TAG ? h >> 3 : compact_tree.child0[compact_index(ptr)];
+    if (compact_tree.elems[pos] == 0 || compact_tree.elems[pos + 1] == 0) {
+      return NULL;
+    }
+    return make_view(((uintptr_t)(pos + 1) << 3) | 1, type);
+  }
+
+  Quad **slot =
+      h & VIEW_TAG ? (Quad **)(h & ~(uintptr_t)VIEW_BITS) : ((Quad *)ptr)->elems;
+  if (slot[0] == NULL || slot[1] == NULL) {
+    return NULL;
+  }
+  return make_view((uintptr_t)(slot + 1), type);
+}
+
+/*
+ * list_elem() - element i of a list node, counting from 0, in constant time
+ */
+static void *list_elem(void *ptr, int i) {
+  assert(ptr != NULL && !((uintptr_t)ptr & VIEW_TAG));
+  if (compact_is_handle(ptr)) {
+    uint32_t pos = compact_tree.child0[compact_index(ptr)];
+    return compact_handle(compact_tree.elems[pos + i]);
+  }
+  return ((Quad *)ptr)->elems[i];
+}
+
+/*
+ * node_name() - the name of the symbol an ID, call or function node refers to
+ */
+static char *node_name(void *ptr) {
+  assert(ptr != NULL);
+  if (compact_is_handle(ptr)) {
+    int32_t off = compact_tree.val[compact_index(ptr)];
+    assert(off >= 0);
+    return compact_tree.strs + off;
+  }
+  return ((Quad *)ptr)->tableentry->name;
+}
+
+NodeType ast_node_type(void *ptr) {
+  assert(ptr != NULL);
+  if ((uintptr_t)ptr & VIEW_TAG) {
+    return (uintptr_t)ptr & VIEW_EXPR ? EXPR_LIST : STMT_LIST;
+  }
+  if (compact_is_handle(ptr)) {
+    return compact_tree.type[compact_index(ptr)];
+  }
+  return ((Quad *)ptr)->type;
 }
 
 char *func_def_name(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->tableentry->name;
+  return node_name(ptr);
 }
 
 /*
@@ -26,9 +136,15 @@ char *func_def_name(void *ptr) {
  * the number of formal parameters for that function.
  */
 int func_def_nargs(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->tableentry->argcnt;
+  // the formals are an EXPR_LIST, absent if there are none
+  void *formals = node_child(ptr, 0);
+  if (formals == NULL) {
+    return 0;
+  }
+  if (compact_is_handle(formals)) {
+    return compact_tree.val[compact_index(formals)];
+  }
+  return ((Quad *)formals)->immediate;
 }
 
 /*
@@ -41,22 +157,12 @@ int func_def_nargs(void *ptr) {
  * is undefined.
  */
 char *func_def_argname(void *ptr, int n) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
+  assert(ptr != NULL);
 
-  int argcnt = ast->tableentry->argcnt;
+  int argcnt = func_def_nargs(ptr);
 
   if (n > 0 && n <= argcnt) {
-    int i = 1;
-    Quad *curarg = ast->child0;
-
-    while (ast != NULL) {
-      if (i == n) {
-        return curarg->child0->tableentry->name;
-      }
-      i++;
-      curarg = curarg->child1;
-    }
+    return node_name(list_elem(node_child(ptr, 0), n - 1));
   }
 
   return "";
@@ -68,9 +174,7 @@ char *func_def_argname(void *ptr, int n) {
  * points to.
  */
 void *func_def_body(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child1;
+  return node_child(ptr, 1);
 }
 
 /*
@@ -78,9 +182,7 @@ void *func_def_body(void *ptr) {
  * a pointer to a string that is the name of the function being called.
  */
 char *func_call_callee(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->tableentry->name;
+  return node_name(ptr);
 }
 
 /*
@@ -88,9 +190,7 @@ char *func_call_callee(void *ptr) {
  * a pointer to the AST that is the list of arguments to the call.
  */
 void *func_call_args(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child0;
+  return node_child(ptr, 0);
 }
 
 /*
@@ -98,9 +198,7 @@ void *func_call_args(void *ptr) {
  * a pointer to the AST of the statement at the beginning of this list.
  */
 void *stmt_list_head(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child0;
+  return list_head(ptr);
 }
 
 /*
@@ -109,9 +207,7 @@ void *stmt_list_head(void *ptr) {
  * next node in the list).
  */
 void *stmt_list_rest(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child1;
+  return list_rest(ptr);
 }
 
 /*
@@ -119,9 +215,7 @@ void *stmt_list_rest(void *ptr) {
  * a pointer to the AST of the expression at the beginning of this list.
  */
 void *expr_list_head(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child0;
+  return list_head(ptr);
 }
 
 /*
@@ -130,9 +224,7 @@ void *expr_list_head(void *ptr) {
  * next node in the list).
  */
 void *expr_list_rest(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child1;
+  return list_rest(ptr);
 }
 
 /*
@@ -140,9 +232,7 @@ void *expr_list_rest(void *ptr) {
  * pointer to the name of the identifier (a string).
  */
 char *expr_id_name(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->tableentry->name;
+  return node_name(ptr);
 }
 
 /*
@@ -150,9 +240,11 @@ char *expr_id_name(void *ptr) {
  * integer value of the constant.
  */
 int expr_intconst_val(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->immediate;
+  assert(ptr != NULL);
+  if (compact_is_handle(ptr)) {
+    return compact_tree.val[compact_index(ptr)];
+  }
+  return ((Quad *)ptr)->immediate;
 }
 
 /*
@@ -160,9 +252,7 @@ int expr_intconst_val(void *ptr) {
  * expr_operand_1() returns a pointer to the AST of the first operand.
  */
 void *expr_operand_1(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child0;
+  return node_child(ptr, 0);
 }
 
 /*
@@ -170,9 +260,7 @@ void *expr_operand_1(void *ptr) {
  * expr_operand_2() returns a pointer to the AST of the second operand.
  */
 void *expr_operand_2(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child1;
+  return node_child(ptr, 1);
 }
 
 /*
@@ -180,9 +268,7 @@ void *expr_operand_2(void *ptr) {
  * a pointer to the AST for the expression tested by the if statement.
  */
 void *stmt_if_expr(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child0;
+  return node_child(ptr, 0);
 }
 
 /*
@@ -191,9 +277,7 @@ void *stmt_if_expr(void *ptr) {
  * statement to be executed if the condition is true.
  */
 void *stmt_if_then(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child1;
+  return node_child(ptr, 1);
 }
 
 /*
@@ -202,9 +286,7 @@ void *stmt_if_then(void *ptr) {
  * statement to be executed if the condition is false.
  */
 void *stmt_if_else(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child2;
+  return node_child(ptr, 2);
 }
 
 /*
@@ -213,9 +295,7 @@ void *stmt_if_else(void *ptr) {
  * assignment.
  */
 char *stmt_assg_lhs(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child0->tableentry->name;
+  return node_name(node_child(ptr, 0));
 }
 
 /*
@@ -223,9 +303,7 @@ char *stmt_assg_lhs(void *ptr) {
  * returns a pointer to the AST of the expression on the RHS of the assignment.
  */
 void *stmt_assg_rhs(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child1;
+  return node_child(ptr, 1);
 }
 
 /*
@@ -233,9 +311,7 @@ void *stmt_assg_rhs(void *ptr) {
  * returns a pointer to the AST of the expression tested by the while statement.
  */
 void *stmt_while_expr(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child0;
+  return node_child(ptr, 0);
 }
 
 /*
@@ -243,9 +319,7 @@ void *stmt_while_expr(void *ptr) {
  * returns a pointer to the AST of the body of the while statement.
  */
 void *stmt_while_body(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child1;
+  return node_child(ptr, 1);
 }
 
 /*
@@ -253,7 +327,5 @@ void *stmt_while_body(void *ptr) {
  * returns a pointer to the AST of the expression whose value is returned.
  */
 void *stmt_return_expr(void *ptr) {
-  Quad *ast = ptr;
-  assert(ast != NULL);
-  return ast->child0;
+  return node_child(ptr, 0);
 }
@@ -41,14 +41,24 @@ typedef enum {
   OR          /* || */
 } NodeType;
 
+/*
+ * STMT_LIST and EXPR_LIST nodes hold all of a list's elements: immediate is
+ * their count and elems a NULL-terminated array of them.  Other nodes use
+ * child0..child2.
+ */
 typedef struct quad Quad;
 struct quad {
   NodeType type;
   symboltab *tableentry;
   int immediate;
-  Quad *child0;
-  Quad *child1;
-  Quad *child2;
+  union {
+    struct {
+      Quad *child0;
+      Quad *child1;
+      Quad *child2;
+    };
+    Quad **elems;
+  };
 };
 
 /*******************************************************************************
@@ -113,7 +123,8 @@ void *stmt_list_head(void *ptr);
 /*
  * ptr: pointer to an AST node for a statement list; stmt_list_rest() returns
  * a pointer to the AST of the rest of this list (i.e., the pointer to the
- * next node in the list).
+ * next node in the list).  The rest is a view into the list's elements that
+ * the list getters accept like a list node; it is NULL at the end.
  */
 void *stmt_list_rest(void *ptr);
 
@@ -126,7 +137,7 @@ void *expr_list_head(void *ptr);
 /*
  * ptr: pointer to an AST node for an expression list; expr_list_rest() returns
  * a pointer to the AST of the rest of this list (i.e., the pointer to the
- * next node in the list).
+ * next node in the list).  As with stmt_list_rest(), this is a view.
  */
 void *expr_list_rest(void *ptr);
 
@@ -0,0 +1,216 @@
+/*
+ * Author: Edward Fattell
+ * File: astcompact.c
+ * Purpose: Flattening Quad trees into compact AST storage
+ */
+#include "astcompact.h"
+#include "ast-walk.h"
+#include <stdlib.h>
+#include <string.h>
+
+CompactAst compact_tree;
+
+int compact_step(AstWalk *walk, AstFrame *frame);
+
+void compact_init(CompactAst *ast) {
+  ast->cap = 1024;
+  ast->type = malloc(sizeof(uint8_t) * ast->cap);
+  ast->child0 = malloc(sizeof(uint32_t) * ast->cap);
+  ast->child1 = malloc(sizeof(uint32_t) * ast->cap);
+  ast->child2 = malloc(sizeof(uint32_t) * ast->cap);
+  ast->val = malloc(sizeof(int32_t) * ast->cap);
+  ast->count = 1;
+  ast->capelems = 1024;
+  ast->elems = malloc(sizeof(uint32_t) * ast->capelems);
+  ast->nelems = 1;
+  ast->capstrs = 4096;
+  ast->strs = malloc(ast->capstrs);
+  ast->nstrs = 0;
+  ast->nnameslots = 256;
+  ast->namekeys = calloc(ast->nnameslots, sizeof(char *));
+  ast->nameoffs = malloc(sizeof(uint32_t) * ast->nnameslots);
+  ast->nnames = 0;
+  ast_walk_init(&ast->walk, compact_step, ast);
+}
+
+void compact_free(CompactAst *ast) {
+  free(ast->type);
+  free(ast->child0);
+  free(ast->child1);
+  free(ast->child2);
+  free(ast->val);
+  free(ast->elems);
+  free(ast->strs);
+  free(ast->namekeys);
+  free(ast->nameoffs);
+  ast_walk_free(&ast->walk);
+  memset(ast, 0, sizeof(CompactAst));
+}
+
+void compact_reset(CompactAst *ast) {
+  ast->count = 1;
+  ast->nelems = 1;
+}
+
+uint32_t compact_node(CompactAst *ast, NodeType type) {
+  if (ast->count == ast->cap) {
+    ast->cap *= 2;
+    ast->type = realloc(ast->type, sizeof(uint8_t) * ast->cap);
+    ast->child0 = realloc(ast->child0, sizeof(uint32_t) * ast->cap);
+    ast->child1 = realloc(ast->child1, sizeof(uint32_t) * ast->cap);
+    ast->child2 = realloc(ast->child2, sizeof(uint32_t) * ast->cap);
+    ast->val = realloc(ast->val, sizeof(int32_t) * ast->cap);
+  }
+
+  uint32_t idx = ast->count++;
+  ast->type[idx] = type;
+  ast->child0[idx] = 0;
+  ast->child1[idx] = 0;
+  ast->child2[idx] = 0;
+  ast->val[idx] = 0;
+  return idx;
+}
+
+/*
+ * reserve_elems() - makes room for a list of n elements plus its terminating
+ *                   0, and returns the position of the first
+ */
+uint32_t reserve_elems(CompactAst *ast, uint32_t n) {
+  while (ast->nelems + n + 1 > ast->capelems) {
+    ast->capelems *= 2;
+    ast->elems = realloc(ast->elems, sizeof(uint32_t) * ast->capelems);
+  }
+
+  uint32_t pos = ast->nelems;
+  ast->elems[pos + n] = 0;
+  ast->nelems += n + 1;
+  return pos;
+}
+
+uint32_t compact_list(CompactAst *ast, NodeType type, const uint32_t *items,
+                      uint32_t n) {
+  uint32_t idx = compact_node(ast, type);
+  uint32_t pos = reserve_elems(ast, n);
+
+  memcpy(ast->elems + pos, items, sizeof(uint32_t) * n);
+  ast->child0[idx] = pos;
+  ast->val[idx] = n;
+  return idx;
+}
+
+/*
+ * name_slot() - the slot for an interned name in the name table; names are
+ *               unique pointers, so they hash by address
+ */
+uint32_t name_slot(CompactAst *ast, const char *name) {
+  uint32_t mask = ast->nnameslots - 1;
+  uint32_t i = (uint32_t)(((uintptr_t)name * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+
+  while (ast->namekeys[i] != NULL && ast->namekeys[i] != name) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+/*
+ * name_offset() - the offset of name in strs, copying it in the first time
+ */
+uint32_t name_offset(CompactAst *ast, const char *name) {
+  uint32_t slot = name_slot(ast, name);
+  if (ast->namekeys[slot] != NULL) {
+    return ast->nameoffs[slot];
+  }
+
+  uint32_t len = strlen(name) + 1;
+  while (ast->nstrs + len > ast->capstrs) {
+    ast->capstrs *= 2;
+    ast->strs = realloc(ast->strs, ast->capstrs);
+  }
+  uint32_t off = ast->nstrs;
+  memcpy(ast->strs + off, name, len);
+  ast->nstrs += len;
+
+  ast->namekeys[slot] = name;
+  ast->nameoffs[slot] = off;
+  // keep the table at most half full
+  if (++ast->nnames * 2 > ast->nnameslots) {
+    const char **oldkeys = ast->namekeys;
+    uint32_t *oldoffs = ast->nameoffs;
+    uint32_t nold = ast->nnameslots;
+
+    ast->nnameslots *= 2;
+    ast->namekeys = calloc(ast->nnameslots, sizeof(char *));
+    ast->nameoffs = malloc(sizeof(uint32_t) * ast->nnameslots);
+    for (uint32_t i = 0; i < nold; i++) {
+      if (oldkeys[i] != NULL) {
+        uint32_t j = name_slot(ast, oldkeys[i]);
+        ast->namekeys[j] = oldkeys[i];
+        ast->nameoffs[j] = oldoffs[i];
+      }
+    }
+    free(oldkeys);
+    free(oldoffs);
+  }
+  return off;
+}
+
+// frame->arg1 for an element of a list, whose place is in elems
+#define ELEM_SLOT 3
+
+/*
+ * compact_step() - copies the Quad in frame into ast (the walk's context) and
+ *                  links it to its place: for a list element, position
+ *                  frame->arg0 of elems; otherwise child frame->arg1 of node
+ *                  frame->arg0, which is 0 for the root
+ */
+int compact_step(AstWalk *walk, AstFrame *frame) {
+  CompactAst *ast = walk->ctx;
+  Quad *tree = frame->node;
+
+  uint32_t idx = compact_node(ast, tree->type);
+  if (frame->arg1 == ELEM_SLOT) {
+    ast->elems[frame->arg0] = idx;
+  } else if (frame->arg0) {
+    uint32_t *child = frame->arg1 == 0   ? ast->child0
+                      : frame->arg1 == 1 ? ast->child1
+                                         : ast->child2;
+    child[frame->arg0] = idx;
+  }
+
+  if (tree->type == STMT_LIST || tree->type == EXPR_LIST) {
+    uint32_t pos = reserve_elems(ast, tree->immediate);
+    ast->child0[idx] = pos;
+    ast->val[idx] = tree->immediate;
+    // push the last first so the elements are numbered in order
+    for (int i = tree->immediate - 1; i >= 0; i--) {
+      ast_walk_push(walk, tree->elems[i], pos + i, ELEM_SLOT);
+    }
+    return 0;
+  }
+
+  if (tree->type == INTCONST) {
+    ast->val[idx] = tree->immediate;
+  } else if (tree->tableentry != NULL) {
+    ast->val[idx] = name_offset(ast, tree->tableentry->name);
+  } else {
+    ast->val[idx] = -1;
+  }
+
+  // number child0's subtree first, then child1's, then child2's
+  ast_walk_push(walk, tree->child2, idx, 2);
+  ast_walk_push(walk, tree->child1, idx, 1);
+  ast_walk_push(walk, tree->child0, idx, 0);
+  return 0;
+}
+
+uint32_t compact_add(CompactAst *ast, Quad *tree) {
+  if (tree == NULL) {
+    return 0;
+  }
+
+  // the root is the first node added
+  uint32_t root = ast->count;
+  ast->walk.ctx = ast;
+  ast_walk(&ast->walk, tree, 0, 0);
+  return root;
+}
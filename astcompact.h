@@ -0,0 +1,83 @@
+/*
+ * File: astcompact.h
+ * Author: Edward Fattell
+ * Purpose: Compact AST storage.  A function's tree is flattened into one set
+ *          of parallel arrays indexed by 32-bit node numbers, with names
+ *          copied into a string area of its own, so the whole tree can be
+ *          saved or copied with a memcpy of each array.  The getters in ast.c
+ *          accept a compact node wherever they accept a Quad pointer.
+ */
+
+#ifndef __ASTCOMPACT_H__
+#define __ASTCOMPACT_H__
+
+#include "ast.h"
+#include "ast-walk.h"
+#include <stdint.h>
+
+struct compactast {
+  uint8_t *type;    /* NodeType of each node */
+  uint32_t *child0; /* children, as node numbers; 0 if there is none */
+  uint32_t *child1;
+  uint32_t *child2;
+  int32_t *val;     /* INTCONST value, offset of the node's name in strs, or
+                       a list's element count */
+  uint32_t count;   /* nodes in use; node 0 is never used */
+  uint32_t cap;
+  uint32_t *elems;  /* list elements; a list's child0 is the position of its
+                       first, and each list ends with a 0 */
+  uint32_t nelems;  /* positions in use; position 0 is never used */
+  uint32_t capelems;
+  char *strs;       /* NUL-terminated names */
+  uint32_t nstrs;
+  uint32_t capstrs;
+  const char **namekeys; /* interned name -> offset in strs, open-addressed */
+  uint32_t *nameoffs;
+  uint32_t nnameslots;
+  uint32_t nnames;
+  AstWalk walk;     /* compact_add()'s traversal stack, kept between calls */
+} typedef CompactAst;
+
+/*
+ * compact_tree is the tree that compact handles refer to.
+ */
+extern CompactAst compact_tree;
+
+/*
+ * compact_init() prepares an empty tree and compact_free() releases it.
+ * compact_reset() drops every node but keeps the names and the storage.
+ */
+void compact_init(CompactAst *ast);
+void compact_free(CompactAst *ast);
+void compact_reset(CompactAst *ast);
+
+/*
+ * compact_node() appends a node of the given type with no children and
+ * returns its number.
+ */
+uint32_t compact_node(CompactAst *ast, NodeType type);
+
+/*
+ * compact_list() appends a list node of the given type holding the n nodes in
+ * items, and returns its number.
+ */
+uint32_t compact_list(CompactAst *ast, NodeType type, const uint32_t *items,
+                      uint32_t n);
+
+/*
+ * compact_add() copies the Quad tree below tree into ast and returns the
+ * number of its root, or 0 if tree is NULL.
+ */
+uint32_t compact_add(CompactAst *ast, Quad *tree);
+
+/*
+ * A handle is what the getters are given for a node of compact_tree: its
+ * number shifted left three bits with the low bit set, which no Quad pointer
+ * has.  The two bits above it are left for the list views made in ast.c.
+ */
+#define compact_is_handle(ptr) (((uintptr_t)(ptr)&1) != 0)
+#define compact_index(ptr) ((uint32_t)((uintptr_t)(ptr) >> 3))
+#define compact_handle(idx) \
+  ((idx) ? (void *)(((uintptr_t)(idx) << 3) | 1) : NULL)
+
+#endif /* __ASTCOMPACT_H__ */
@@ -0,0 +1,130 @@
+/*
+ * Author: Edward Fattell
+ * File: bench/editbench.c
+ * Purpose: Benchmark for incremental re-lexing.  A generated program is
+ *          tokenized once, then edited the way an editor would: typing and
+ *          deleting a few characters, and opening and later closing a
+ *          comment.  Each edit is applied with scan_edit() and timed against
+ *          tokenizing the whole edited input again, kept in a plain copy of
+ *          the text, and the incremental token array and line numbers are
+ *          checked against the full ones.
+ *
+ *          usage: editbench [megabytes] [edits]
+ */
+#include "../scanner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+char *sample = "int x, y;\n"
+               "/* add() - returns the sum of its arguments */\n"
+               "int add(int a, int b) {\n"
+               "    x = a + b * 12345;\n"
+               "    if (x >= y && y != 0) { return x / y; }\n"
+               "    return add(x, 1);\n"
+               "}\n\n";
+
+// edits to apply at random places, in pairs so the input stays similar
+char *inserts[] = {"z", "zz1", " ", "\n", "/* ", " */", "(", ")"};
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * same_tokens() - compares an incrementally kept token array with a fresh
+ *                 one; IDs are compared by name since ids may differ
+ */
+int same_tokens(Scanner *sa, TokenBuf *a, Scanner *sb, TokenBuf *b) {
+  if (a->count != b->count) {
+    return 0;
+  }
+  for (int i = 0; i < a->count; i++) {
+    if (a->kind[i] != b->kind[i] || a->off[i] != b->off[i] ||
+        a->len[i] != b->len[i]) {
+      return 0;
+    }
+    if (a->kind[i] == ID) {
+      if (strcmp(id_name(sa, a->val[i]), id_name(sb, b->val[i]))) {
+        return 0;
+      }
+    } else if (a->val[i] != b->val[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  long target = (argc > 1 ? atol(argv[1]) : 16) << 20;
+  int nedits = argc > 2 ? atoi(argv[2]) : 200;
+
+  long srclen = strlen(sample);
+  long len = 0;
+  char *buf = malloc(target + srclen);
+  while (len < target) {
+    memcpy(buf + len, sample, srclen);
+    len += srclen;
+  }
+
+  Scanner *sc = scanner_create_text(buf, len);
+  TokenBuf toks;
+  tokbuf_init(&toks);
+  scan_all(sc, &toks);
+  printf("input: %ld bytes, %d tokens\n", len, toks.count);
+  scan_edit_begin(sc, &toks);
+  tokbuf_free(&toks);
+
+  double inc = 0;
+  double full = 0;
+  long rescanned = 0;
+  srand(453);
+  for (int e = 0; e < nedits; e++) {
+    long start = rand() % len;
+    char *text = inserts[rand() % (sizeof(inserts) / sizeof(char *))];
+    long oldlen = e % 2 ? 1 : 0;
+    long newlen = strlen(text);
+
+    double t = now();
+    TokEdit edit = scan_edit(sc, start, oldlen, text, newlen);
+    inc += now() - t;
+    rescanned += edit.added;
+
+    buf = realloc(buf, len + newlen);
+    memmove(buf + start + newlen, buf + start + oldlen, len - start - oldlen);
+    memcpy(buf + start, text, newlen);
+    len += newlen - oldlen;
+
+    t = now();
+    Scanner *fresh = scanner_create_text(buf, len);
+    TokenBuf all;
+    tokbuf_init(&all);
+    scan_all(fresh, &all);
+    full += now() - t;
+
+    tokbuf_init(&toks);
+    scan_edit_tokens(sc, &toks);
+    long off = rand() % (len + 1);
+    if (!same_tokens(sc, &toks, fresh, &all) ||
+        src_line(sc, off) != src_line(fresh, off) ||
+        src_col(sc, off) != src_col(fresh, off)) {
+      fprintf(stderr, "editbench: edit %d gave a different stream\n", e);
+      return 1;
+    }
+    tokbuf_free(&toks);
+    tokbuf_free(&all);
+    scanner_destroy(fresh);
+  }
+  if (memcmp(scan_text(sc), buf, len) != 0) {
+    fprintf(stderr, "editbench: the edited text differs\n");
+    return 1;
+  }
+
+  printf("scan_edit   %10.1f us/edit  (%.1f tokens scanned per edit)\n",
+         inc / nedits * 1e6, (double)rescanned / nedits);
+  printf("full rescan %10.1f us/edit\n", full / nedits * 1e6);
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Author: Edward Fattell
+ * File: bench/intbench.c
+ * Purpose: Benchmark for integer constant decoding.  Generates constant-heavy
+ *          C-- assignments, finds each literal in the text the way the
+ *          scanner's DFA delimits it, and decodes every literal with the
+ *          scanner's decode_intcon() and with the old approach of re-reading
+ *          the digits seen so far with atoi() after each new digit.  Every
+ *          value is checked against strtoll(), including the ones that
+ *          overflow an int.
+ *
+ *          usage: intbench [nstmts] [rounds]
+ */
+#include "../scanner.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct literal {
+  char *text;
+  int len;
+} typedef literal;
+
+/*
+ * make_program() - nstmts statements of the form "x = 12 + 3456 * 7;" whose
+ *                  constants are 1 to 10 digits long, with one in a hundred
+ *                  of them too large for an int
+ */
+char *make_program(int nstmts, long *len) {
+  char *text = malloc((long)nstmts * 64 + 1);
+  long pos = 0;
+
+  srand(453);
+  for (int i = 0; i < nstmts; i++) {
+    pos += sprintf(text + pos, "x%d =", i % 100);
+    int nterms = 1 + rand() % 3;
+    for (int t = 0; t < nterms; t++) {
+      int ndigits = 1 + rand() % 9;
+      if (rand() % 100 == 0) {
+        ndigits = 10 + rand() % 3;
+      }
+      text[pos++] = t ? '+' : ' ';
+      text[pos++] = '1' + rand() % 9;
+      for (int d = 1; d < ndigits; d++) {
+        text[pos++] = '0' + rand() % 10;
+      }
+    }
+    pos += sprintf(text + pos, ";\n");
+  }
+  text[pos] = '\0';
+  *len = pos;
+  return text;
+}
+
+/*
+ * find_literals() - every maximal digit run that does not continue an
+ *                   identifier, which is what the DFA accepts as an INTCON
+ */
+literal *find_literals(char *text, long len, int *count) {
+  literal *lits = malloc(sizeof(literal) * (len / 2 + 1));
+  int n = 0;
+
+  for (long pos = 0; pos < len;) {
+    if (isalpha(text[pos]) || text[pos] == '_') {
+      while (pos < len && (isalnum(text[pos]) || text[pos] == '_')) {
+        pos++;
+      }
+    } else if (isdigit(text[pos])) {
+      lits[n].text = text + pos;
+      while (pos < len && isdigit(text[pos])) {
+        pos++;
+      }
+      lits[n].len = text + pos - lits[n].text;
+      n++;
+    } else {
+      pos++;
+    }
+  }
+  *count = n;
+  return lits;
+}
+
+/*
+ * atoi_decode() - how constants were decoded before decode_intcon(): the
+ *                 lexeme grows a digit at a time and is re-read each time
+ */
+int atoi_decode(const char *text, int len) {
+  char buf[32];
+  int val = 0;
+
+  for (int i = 0; i < len && i < 31; i++) {
+    buf[i] = text[i];
+    buf[i + 1] = '\0';
+    val = atoi(buf);
+  }
+  return val;
+}
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  int nstmts = argc > 1 ? atoi(argv[1]) : 1000000;
+  int rounds = argc > 2 ? atoi(argv[2]) : 10;
+  long len;
+  int nlits;
+
+  char *text = make_program(nstmts, &len);
+  literal *lits = find_literals(text, len, &nlits);
+
+  // check decode_intcon() against strtoll() before timing anything
+  int overflows = 0;
+  for (int i = 0; i < nlits; i++) {
+    char buf[32];
+    memcpy(buf, lits[i].text, lits[i].len);
+    buf[lits[i].len] = '\0';
+    long long want = strtoll(buf, NULL, 10);
+    int got = decode_intcon(lits[i].text, lits[i].len);
+    if (want > INT_MAX ? got != -1 : got != want) {
+      fprintf(stderr, "intbench: decode_intcon(%s) = %d\n", buf, got);
+      return 1;
+    }
+    overflows += got < 0;
+  }
+  printf("%ld bytes, %d constants, %d out of range\n", len, nlits, overflows);
+
+  long sum = 0;
+  double start = now();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < nlits; i++) {
+      sum += decode_intcon(lits[i].text, lits[i].len);
+    }
+  }
+  double fast = now() - start;
+
+  start = now();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < nlits; i++) {
+      sum += atoi_decode(lits[i].text, lits[i].len);
+    }
+  }
+  double slow = now() - start;
+
+  double total = (double)nlits * rounds;
+  printf("decode_intcon  %6.2f ns/constant\n", fast / total * 1e9);
+  printf("atoi per digit %6.2f ns/constant\n", slow / total * 1e9);
+  printf("(checksum %ld)\n", sum);
+  return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Author: Edward Fattell
+ * File: bench/kwbench.c
+ * Purpose: Microbenchmark for keyword recognition.  Classifies a generated
+ *          identifier-heavy word list with the scanner's perfect-hash
+ *          keyword() and with a linear walk of the keyword list, which is
+ *          how identifiers were classified before the hash.
+ *
+ *          usage: kwbench [nwords] [rounds]
+ */
+#include "../scanner.h"
+#include "../scantab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern Token keyword(const char *text, int len);
+
+struct word {
+  char *text;
+  int len;
+} typedef word;
+
+/*
+ * linear_keyword() - the keyword lookup that keyword() replaced
+ */
+Token linear_keyword(const char *text, int len) {
+  for (int i = 0; i < SCAN_NKEYWORDS; i++) {
+    if (scan_keywords[i].len == len &&
+        !memcmp(scan_keywords[i].text, text, len)) {
+      return scan_keywords[i].toke;
+    }
+  }
+  return ID;
+}
+
+/*
+ * make_words() - one word in five is a keyword, the rest are identifiers of
+ *                1 to 12 characters, several sharing a keyword's first letter
+ */
+word *make_words(int nwords) {
+  static const char idchars[] = "abcdefghijklmnopqrstuvwxyz_0123456789";
+  word *words = malloc(sizeof(word) * nwords);
+
+  srand(453);
+  for (int i = 0; i < nwords; i++) {
+    if (rand() % 5 == 0) {
+      int k = rand() % SCAN_NKEYWORDS;
+      words[i].text = strdup(scan_keywords[k].text);
+      words[i].len = scan_keywords[k].len;
+      continue;
+    }
+
+    int len = 1 + rand() % 12;
+    words[i].text = malloc(len + 1);
+    words[i].text[0] = "iewrx"[rand() % 5];
+    for (int j = 1; j < len; j++) {
+      words[i].text[j] = idchars[rand() % (sizeof(idchars) - 1)];
+    }
+    words[i].text[len] = '\0';
+    words[i].len = len;
+  }
+  return words;
+}
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  int nwords = argc > 1 ? atoi(argv[1]) : 1000000;
+  int rounds = argc > 2 ? atoi(argv[2]) : 20;
+  word *words = make_words(nwords);
+  long nkw[2] = {0, 0};
+  double secs[2];
+
+  for (int i = 0; i < nwords; i++) {
+    if (keyword(words[i].text, words[i].len) !=
+        linear_keyword(words[i].text, words[i].len)) {
+      fprintf(stderr, "kwbench: lookups disagree on %s\n", words[i].text);
+      return 1;
+    }
+  }
+
+  for (int m = 0; m < 2; m++) {
+    double start = now();
+    for (int r = 0; r < rounds; r++) {
+      for (int i = 0; i < nwords; i++) {
+        Token t = m ? keyword(words[i].text, words[i].len)
+                    : linear_keyword(words[i].text, words[i].len);
+        nkw[m] += t != ID;
+      }
+    }
+    secs[m] = now() - start;
+  }
+
+  long nlookups = (long)nwords * rounds;
+  printf("%ld lookups, %ld keywords\n", nlookups, nkw[1]);
+  printf("linear list:  %8.2f ns/lookup\n", secs[0] * 1e9 / nlookups);
+  printf("perfect hash: %8.2f ns/lookup\n", secs[1] * 1e9 / nlookups);
+  return 0;
+}
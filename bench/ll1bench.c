@@ -0,0 +1,247 @@
+/*
+ * Author: Edward Fattell
+ * File: bench/ll1bench.c
+ * Purpose: Benchmark for the table-driven LL(1) parser in ll1.c against the
+ *          recursive descent parser.  Each input file both parsers accept
+ *          is copied over and over, with every identifier of copy k given
+ *          the suffix _k so no name is declared twice, until the corpus
+ *          reaches the target size.  parse() then runs on the corpus as
+ *          the compiler would, once with --ll1 and once without, each in a
+ *          child process since it exits on an error.  The two runs are
+ *          not like for like: --ll1 only recognizes the syntax, while the
+ *          recursive descent run also fills the symbol table and builds
+ *          each function's AST, and the report labels them so.  Scanning
+ *          alone and ll1_parse() alone are timed too.
+ *
+ *          usage: ll1bench [-m megabytes] [file ...]
+ *          e.g.   ll1bench -m 16 betterTests/testSrc*.c
+ */
+#include "../ll1.h"
+#include "../parser.h"
+#include "../scanner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// the driver's flags, which parse() reads
+int chk_decl_flag = 0;
+int print_ast_flag = 0;
+int gen_code_flag = 0;
+int keep_ast_flag = 0;
+int compact_ast_flag = 0;
+int ll1_flag = 0;
+int max_errors = 1;
+int defer_calls_flag = 0;
+
+char *sample = "int x, y;\n"
+               "int add(int a, int b) {\n"
+               "    x = a + b * 12345;\n"
+               "    if (x >= y && y != 0) { return x / y; }\n"
+               "    while (-(x - 1) > 0 || y < 3) x = (x - 1) * 2;\n"
+               "    return add(x, 1);\n"
+               "}\n";
+
+char *read_file(char *path, long *len) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    perror(path);
+    exit(1);
+  }
+  fseek(fp, 0, SEEK_END);
+  *len = ftell(fp);
+  rewind(fp);
+
+  char *text = malloc(*len + 1);
+  *len = fread(text, 1, *len, fp);
+  fclose(fp);
+  return text;
+}
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * write_corpus() - writes text to a fresh temporary file and returns its
+ *                  descriptor
+ */
+int write_corpus(const char *text, long len) {
+  char path[] = "/tmp/ll1benchXXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    exit(1);
+  }
+  unlink(path);
+  if (write(fd, text, len) != len) {
+    perror("write");
+    exit(1);
+  }
+  return fd;
+}
+
+/*
+ * run_parse() - runs parse() in a child with fd as its input, with or without
+ *               --ll1; returns the seconds it took, or -1 if it failed
+ */
+double run_parse(int fd, int ll1) {
+  int pfd[2];
+  double secs = -1;
+
+  if (pipe(pfd) < 0) {
+    perror("pipe");
+    exit(1);
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(pfd[0]);
+    dup2(fd, STDIN_FILENO);
+    lseek(STDIN_FILENO, 0, SEEK_SET);
+    fclose(stderr);
+    ll1_flag = ll1;
+
+    double start = now();
+    parse();
+    secs = now() - start;
+    if (write(pfd[1], &secs, sizeof(secs)) != sizeof(secs)) {
+      exit(1);
+    }
+    exit(0);
+  }
+
+  close(pfd[1]);
+  int status;
+  if (read(pfd[0], &secs, sizeof(secs)) != sizeof(secs)) {
+    secs = -1;
+  }
+  close(pfd[0]);
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    secs = -1;
+  }
+  return secs;
+}
+
+/*
+ * rename_copy() - appends text to out with every identifier suffixed by _k,
+ *                 keeping everything between the tokens as it is
+ */
+long rename_copy(const char *text, long len, int k, char **out, long *cap,
+                 long outlen) {
+  Scanner *sc = scanner_create_text(text, len);
+  TokenBuf toks;
+  tokbuf_init(&toks);
+  scan_all(sc, &toks);
+
+  long prev = 0;
+  for (int i = 0; i < toks.count; i++) {
+    long off = toks.kind[i] == TOK_EOF ? len : toks.off[i];
+    long end = toks.kind[i] == TOK_EOF ? len : off + toks.len[i];
+    if (outlen + (end - prev) + 16 > *cap) {
+      *cap = (*cap + (end - prev) + 16) * 2;
+      *out = realloc(*out, *cap);
+    }
+    memcpy(*out + outlen, text + prev, end - prev);
+    outlen += end - prev;
+    if (toks.kind[i] == ID) {
+      outlen += sprintf(*out + outlen, "_%d", k);
+    }
+    prev = end;
+  }
+
+  tokbuf_free(&toks);
+  scanner_destroy(sc);
+  return outlen;
+}
+
+int main(int argc, char *argv[]) {
+  long target = 16L << 20;
+  int argi = 1;
+
+  if (argc > 2 && !strcmp(argv[1], "-m")) {
+    target = atol(argv[2]) << 20;
+    argi = 3;
+  }
+
+  // gather the files both parsers accept
+  char **srcs = malloc(sizeof(char *) * (argc + 1));
+  long *srclens = malloc(sizeof(long) * (argc + 1));
+  int nfiles = 0;
+  if (argi == argc) {
+    srcs[nfiles] = strdup(sample);
+    srclens[nfiles++] = strlen(sample);
+  }
+  for (int i = argi; i < argc; i++) {
+    long len;
+    char *text = read_file(argv[i], &len);
+    int fd = write_corpus(text, len);
+    if (run_parse(fd, 1) < 0 || run_parse(fd, 0) < 0) {
+      printf("skipping %s: not accepted by both parsers\n", argv[i]);
+      free(text);
+    } else {
+      srcs[nfiles] = text;
+      srclens[nfiles++] = len;
+    }
+    close(fd);
+  }
+  if (nfiles == 0) {
+    fprintf(stderr, "ll1bench: empty corpus\n");
+    return 1;
+  }
+
+  // repeat the files up to the target size, each copy renamed apart
+  long cap = target + (1 << 20);
+  char *buf = malloc(cap);
+  long len = 0;
+  for (int k = 0; len < target; k++) {
+    len = rename_copy(srcs[k % nfiles], srclens[k % nfiles], k, &buf, &cap,
+                      len);
+    buf[len++] = '\n';
+  }
+  int fd = write_corpus(buf, len);
+
+  lseek(fd, 0, SEEK_SET);
+  Scanner *sc = scanner_create(fd);
+  TokenBuf toks;
+  tokbuf_init(&toks);
+  double start = now();
+  scan_all_parallel(sc, &toks, 0);
+  double scan_secs = now() - start;
+
+  int expected;
+  start = now();
+  int bad = ll1_parse(&toks, &expected);
+  double ll1_secs = now() - start;
+  if (bad >= 0) {
+    fprintf(stderr, "ll1bench: ll1_parse() rejected token %d\n", bad);
+    return 1;
+  }
+
+  printf("corpus: %ld bytes, %d tokens, from %d files\n", len, toks.count,
+         nfiles);
+  printf("scan only                            %8.1f MB/s\n",
+         len / scan_secs / (1 << 20));
+  printf("ll1_parse() only                     %8.1f Mtokens/s\n",
+         toks.count / ll1_secs / 1e6);
+  tokbuf_free(&toks);
+  scanner_destroy(sc);
+
+  double ll1 = run_parse(fd, 1);
+  double rd = run_parse(fd, 0);
+  if (ll1 < 0 || rd < 0) {
+    fprintf(stderr, "ll1bench: parse() failed on the corpus\n");
+    return 1;
+  }
+  printf("parse() --ll1, syntax only           %8.1f MB/s  (%.3f s)\n",
+         len / ll1 / (1 << 20), ll1);
+  printf("parse() recursive, symtab and ASTs   %8.1f MB/s  (%.3f s)\n",
+         len / rd / (1 << 20), rd);
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Author: Edward Fattell
+ * File: bench/parbench.c
+ * Purpose: Benchmark for parallel tokenizing.  The input files (or a
+ *          generated program with long comments) are repeated up to the
+ *          target size and tokenized with scan_all() and with
+ *          scan_all_parallel() on 1, 2, 4, ... threads up to the CPU count.
+ *          Every parallel token stream is checked against the serial one.
+ *
+ *          usage: parbench [-m megabytes] [file ...]
+ */
+#include "../scanner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+char *sample = "int x, y;\n"
+               "/*\n"
+               " * add() - returns the sum of its arguments, padded out so\n"
+               " * that chunk boundaries often land inside a comment\n"
+               " */\n"
+               "int add(int a, int b) {\n"
+               "    x = a + b * 12345;\n"
+               "    if (x >= y && y != 0) { return x / y; }\n"
+               "    return add(x, 1);\n"
+               "}\n\n";
+
+char *read_file(char *path, long *len) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    perror(path);
+    exit(1);
+  }
+  fseek(fp, 0, SEEK_END);
+  *len = ftell(fp);
+  rewind(fp);
+
+  char *text = malloc(*len + 1);
+  *len = fread(text, 1, *len, fp);
+  fclose(fp);
+  return text;
+}
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int same_tokens(TokenBuf *a, TokenBuf *b) {
+  return a->count == b->count && !memcmp(a->kind, b->kind, a->count) &&
+         !memcmp(a->off, b->off, sizeof(uint32_t) * a->count) &&
+         !memcmp(a->len, b->len, sizeof(uint32_t) * a->count) &&
+         !memcmp(a->val, b->val, sizeof(int32_t) * a->count);
+}
+
+int main(int argc, char *argv[]) {
+  long target = 256L << 20;
+  int argi = 1;
+
+  if (argc > 2 && !strcmp(argv[1], "-m")) {
+    target = atol(argv[2]) << 20;
+    argi = 3;
+  }
+
+  long srclen = 0;
+  char *src = NULL;
+  if (argi == argc) {
+    src = strdup(sample);
+    srclen = strlen(sample);
+  }
+  for (int i = argi; i < argc; i++) {
+    long len;
+    char *text = read_file(argv[i], &len);
+    src = realloc(src, srclen + len + 1);
+    memcpy(src + srclen, text, len);
+    srclen += len;
+    src[srclen++] = '\n';
+    free(text);
+  }
+  if (srclen == 0) {
+    fprintf(stderr, "parbench: empty corpus\n");
+    return 1;
+  }
+
+  long len = 0;
+  char *buf = malloc(target + srclen);
+  while (len < target) {
+    memcpy(buf + len, src, srclen);
+    len += srclen;
+  }
+
+  Scanner *sc = scanner_create_text(buf, len);
+  TokenBuf serial;
+  tokbuf_init(&serial);
+  double start = now();
+  scan_all(sc, &serial);
+  double secs = now() - start;
+  scanner_destroy(sc);
+
+  printf("corpus: %ld bytes, %d tokens\n", len, serial.count);
+  printf("serial      %8.1f MB/s\n", len / secs / (1 << 20));
+
+  int ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int n = 1; n <= ncpu || n == 1; n *= 2) {
+    TokenBuf toks;
+    tokbuf_init(&toks);
+    sc = scanner_create_text(buf, len);
+
+    start = now();
+    scan_all_parallel(sc, &toks, n);
+    secs = now() - start;
+
+    if (!same_tokens(&serial, &toks)) {
+      fprintf(stderr, "parbench: %d threads gave a different stream\n", n);
+      return 1;
+    }
+    printf("%2d threads  %8.1f MB/s\n", n, len / secs / (1 << 20));
+    scanner_destroy(sc);
+    tokbuf_free(&toks);
+  }
+  return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * Author: Edward Fattell
+ * File: bench/scanbench.c
+ * Purpose: Scanner throughput benchmark.  Generates synthetic C-- inputs of
+ *          a given size in several token mixes and reports tokens/s and
+ *          MB/s for get_token() and, when built with flex, for the flex
+ *          scanner in cmm.l over the same token set.  The two token streams
+ *          are checked against each other.
+ *
+ *          usage: scanbench [-m megabytes] [-r rounds] [mix ...]
+ *          mixes: ident op comment literal mixed (default: all of them)
+ */
+#include "../scanner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef HAVE_FLEX
+extern FILE *cmmin;
+extern int cmmlex();
+extern void cmmrestart(FILE *fp);
+#endif
+
+char *keywords[] = {"int", "if", "else", "while", "return"};
+char *operators[] = {"+", "-", "*", "/", "=", "==", "!=", "<", "<=",
+                     ">", ">=", "&&", "||", "!", "(", ")", ",", ";"};
+
+struct mix {
+  char *name;
+  int ident;   /* weights of each kind of item */
+  int op;
+  int comment;
+  int literal;
+} typedef Mix;
+
+Mix mixes[] = {
+    {"ident", 70, 25, 0, 5},
+    {"op", 20, 75, 0, 5},
+    {"comment", 20, 15, 60, 5},
+    {"literal", 20, 20, 0, 60},
+    {"mixed", 35, 35, 10, 20},
+};
+
+#define NMIXES (int)(sizeof(mixes) / sizeof(Mix))
+
+/*
+ * put_item() - appends one item of the mix to buf and returns its length
+ */
+int put_item(char *buf, Mix *mix) {
+  static const char idchars[] =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+  int total = mix->ident + mix->op + mix->comment + mix->literal;
+  int pick = rand() % total;
+  int n = 0;
+
+  if ((pick -= mix->ident) < 0) {
+    if (rand() % 6 == 0) {
+      n = sprintf(buf, "%s", keywords[rand() % 5]);
+    } else {
+      int len = 1 + rand() % 16;
+      buf[n++] = idchars[rand() % 53];
+      while (n < len) {
+        buf[n++] = idchars[rand() % 63];
+      }
+    }
+  } else if ((pick -= mix->op) < 0) {
+    n = sprintf(buf, "%s", operators[rand() % 18]);
+  } else if ((pick -= mix->comment) < 0) {
+    int len = 10 + rand() % 300;
+    n = sprintf(buf, "/* ");
+    for (int i = 0; i < len; i++) {
+      buf[n++] = i % 61 == 60 ? '\n' : "abc de*f/ g"[rand() % 11];
+    }
+    n += sprintf(buf + n, " */");
+  } else {
+    int len = 1 + rand() % 9;
+    buf[n++] = '1' + rand() % 9;
+    while (n < len) {
+      buf[n++] = '0' + rand() % 10;
+    }
+  }
+
+  buf[n++] = rand() % 8 ? ' ' : '\n';
+  return n;
+}
+
+/*
+ * make_input() - writes about size bytes of the mix to a temporary file and
+ *                returns its path
+ */
+char *make_input(Mix *mix, long size) {
+  char *path = strdup("/tmp/scanbenchXXXXXX");
+  int fd = mkstemp(path);
+  FILE *fp = fdopen(fd, "w");
+  char item[512];
+
+  srand(453);
+  for (long len = 0; len < size;) {
+    int n = put_item(item, mix);
+    fwrite(item, 1, n, fp);
+    len += n;
+  }
+  fclose(fp);
+  return path;
+}
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * run_get_token() - scans the file with get_token(), adding each token's
+ *                   kind to *sum, and returns the number of tokens
+ */
+long run_get_token(char *path, long *sum) {
+  FILE *fp = fopen(path, "r");
+  Scanner *sc = scanner_create(fileno(fp));
+  long n = 0;
+  int toke;
+
+  while ((toke = get_token(sc)) != EOF) {
+    *sum = *sum * 31 + toke;
+    n++;
+  }
+  scanner_destroy(sc);
+  fclose(fp);
+  return n;
+}
+
+#ifdef HAVE_FLEX
+long run_flex(char *path, long *sum) {
+  FILE *fp = fopen(path, "r");
+  long n = 0;
+  int toke;
+
+  cmmrestart(fp);
+  while ((toke = cmmlex()) != EOF) {
+    *sum = *sum * 31 + toke;
+    n++;
+  }
+  fclose(fp);
+  return n;
+}
+#endif
+
+void report(char *who, double secs, long ntoks, long size) {
+  printf("  %-10s %8.2f Mtok/s %8.1f MB/s\n", who, ntoks / secs / 1e6,
+         size / secs / (1 << 20));
+}
+
+int main(int argc, char *argv[]) {
+  long size = 32L << 20;
+  int rounds = 3;
+  int argi = 1;
+
+  for (; argi + 1 < argc && argv[argi][0] == '-'; argi += 2) {
+    if (!strcmp(argv[argi], "-m")) {
+      size = atol(argv[argi + 1]) << 20;
+    } else if (!strcmp(argv[argi], "-r")) {
+      rounds = atoi(argv[argi + 1]);
+    }
+  }
+
+  for (int m = 0; m < NMIXES; m++) {
+    int wanted = argi == argc;
+    for (int i = argi; i < argc; i++) {
+      wanted |= !strcmp(argv[i], mixes[m].name);
+    }
+    if (!wanted) {
+      continue;
+    }
+
+    char *path = make_input(&mixes[m], size);
+    long ntoks = 0;
+    long sum = 0;
+    double best = 0;
+    for (int r = 0; r < rounds; r++) {
+      double start = now();
+      ntoks = run_get_token(path, &sum);
+      double secs = now() - start;
+      best = r == 0 || secs < best ? secs : best;
+    }
+    printf("%s: %ld bytes, %ld tokens\n", mixes[m].name, size, ntoks);
+    report("get_token", best, ntoks, size);
+
+#ifdef HAVE_FLEX
+    long fsum = 0;
+    long fntoks = 0;
+    for (int r = 0; r < rounds; r++) {
+      double start = now();
+      fntoks = run_flex(path, &fsum);
+      double secs = now() - start;
+      best = r == 0 || secs < best ? secs : best;
+    }
+    if (fntoks != ntoks || fsum != sum) {
+      fprintf(stderr, "scanbench: flex and get_token() disagree on %s\n",
+              mixes[m].name);
+      return 1;
+    }
+    report("flex", best, fntoks, size);
+#else
+    printf("  %-10s not built (flex was not found)\n", "flex");
+#endif
+
+    unlink(path);
+    free(path);
+  }
+  return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Author: Edward Fattell
+ * File: bench/simdbench.c
+ * Purpose: Benchmark for the whitespace and comment kernels in scansimd.c.
+ *          The input files are concatenated and repeated up to the target
+ *          size, then skipped the way rm_cmt() skips them, once with each
+ *          kernel level the CPU supports.  With no files, a comment-heavy
+ *          corpus is generated.
+ *
+ *          usage: simdbench [-m megabytes] [file ...]
+ *          e.g.   simdbench -m 32 tests/multiFunc tests/debray14comments
+ */
+#include "../scansimd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+char *sample =
+    "/*\n"
+    " * Copyright (c) the authors.  Permission is granted to copy, modify\n"
+    " * and distribute this file provided this notice is kept intact.\n"
+    " * THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND.\n"
+    " */\n"
+    "int x, y;\n\n"
+    "/* add() - returns the sum of its arguments */\n"
+    "int add(int a, int b) {\n"
+    "    /* the body */\n"
+    "    x = a;\n"
+    "    return x;\n"
+    "}\n\n";
+
+char *read_file(char *path, long *len) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    perror(path);
+    exit(1);
+  }
+  fseek(fp, 0, SEEK_END);
+  *len = ftell(fp);
+  rewind(fp);
+
+  char *text = malloc(*len + 1);
+  *len = fread(text, 1, *len, fp);
+  fclose(fp);
+  return text;
+}
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * skip_pass() - walks the whole buffer skipping whitespace and comments with
+ *               the selected kernels and stepping over everything else a
+ *               byte at a time; returns the number of newlines skipped
+ */
+long skip_pass(const char *buf, long len) {
+  long lines = 0;
+  long pos = 0;
+
+  while (pos < len) {
+    long end = skip_space(buf, pos, len);
+    lines += count_newlines(buf, pos, end);
+    pos = end;
+
+    if (pos + 1 < len && buf[pos] == '/' && buf[pos + 1] == '*') {
+      long close = find_cmt_close(buf, pos + 2, len);
+      if (close < 0) {
+        pos += 2;
+        continue;
+      }
+      lines += count_newlines(buf, pos, close);
+      pos = close + 2;
+      continue;
+    }
+
+    while (pos < len && buf[pos] != ' ' && buf[pos] != '\n' &&
+           buf[pos] != '\t' && buf[pos] != '/') {
+      pos++;
+    }
+    if (pos < len && buf[pos] == '/') {
+      pos++;
+    }
+  }
+  return lines;
+}
+
+int main(int argc, char *argv[]) {
+  long target = 64L << 20;
+  int argi = 1;
+
+  if (argc > 2 && !strcmp(argv[1], "-m")) {
+    target = atol(argv[2]) << 20;
+    argi = 3;
+  }
+
+  // gather the source corpus
+  long srclen = 0;
+  char *src = NULL;
+  if (argi == argc) {
+    src = strdup(sample);
+    srclen = strlen(sample);
+  }
+  for (int i = argi; i < argc; i++) {
+    long len;
+    char *text = read_file(argv[i], &len);
+    src = realloc(src, srclen + len + 1);
+    memcpy(src + srclen, text, len);
+    srclen += len;
+    src[srclen++] = '\n';
+    free(text);
+  }
+  if (srclen == 0) {
+    fprintf(stderr, "simdbench: empty corpus\n");
+    return 1;
+  }
+
+  // repeat it up to the target size
+  long len = 0;
+  char *buf = malloc(target + srclen);
+  while (len < target) {
+    memcpy(buf + len, src, srclen);
+    len += srclen;
+  }
+
+  printf("corpus: %ld bytes\n", len);
+  long lines = -1;
+  for (SimdLevel level = SIMD_SCALAR; level <= SIMD_AVX2; level++) {
+    if (scan_simd_select(level) != level) {
+      printf("%-8s unsupported\n", scan_simd_name(level));
+      continue;
+    }
+
+    double start = now();
+    long n = skip_pass(buf, len);
+    double secs = now() - start;
+
+    if (lines >= 0 && n != lines) {
+      fprintf(stderr, "simdbench: %s counted %ld lines, expected %ld\n",
+              scan_simd_name(level), n, lines);
+      return 1;
+    }
+    lines = n;
+    printf("%-8s %8.1f MB/s  (%ld lines)\n", scan_simd_name(level),
+           len / secs / (1 << 20), n);
+  }
+  return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * Author: Edward Fattell
+ * File: bench/symbench.c
+ * Purpose: Benchmark for the symbol table.  Declares many globals, then
+ *          parses functions the way parser.c does: push a scope, declare
+ *          thousands of locals (some shadowing globals), look names up, pop.
+ *          Every declaration is preceded by a lookup for a redefinition,
+ *          as createEntry() does.  With -l the same work is done with the
+ *          linked lists that symtab.c replaced.  With -g the program is
+ *          also written out as C-- source, for timing the whole compiler.
+ *
+ *          usage: symbench [-l] [-g file] [globals] [functions] [locals]
+ */
+#include "../intern.h"
+#include "../symtab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * make_names() - interns n names with the given prefix
+ */
+char **make_names(InternPool *pool, char *prefix, int n) {
+  char **names = malloc(sizeof(char *) * n);
+  char buf[32];
+
+  for (int i = 0; i < n; i++) {
+    int len = sprintf(buf, "%s%d", prefix, i);
+    names[i] = intern_name(pool, intern(pool, buf, len));
+  }
+  return names;
+}
+
+/*
+ * local_name() - the name of local i of function f; every tenth one shadows
+ *                a different global while there are globals left
+ */
+char *local_name(char **globals, int nglobals, char **locals, int f, int i) {
+  if (i % 10 == 0 && i / 10 < nglobals) {
+    return globals[(f + i / 10) % nglobals];
+  }
+  return locals[i];
+}
+
+/*
+ * run_symtab() - the benchmark workload on a SymTab; returns the number of
+ *                lookups that found an entry
+ */
+long run_symtab(char **globals, int nglobals, char **locals, int nfuncs,
+                int nlocals) {
+  SymTab tab;
+  long found = 0;
+
+  symtab_init(&tab);
+  for (int i = 0; i < nglobals; i++) {
+    found += symtab_lookup_at(&tab, globals[i], 0) != NULL;
+    symtab_insert(&tab, globals[i], 0);
+  }
+
+  for (int f = 0; f < nfuncs; f++) {
+    symtab_push(&tab);
+    for (int i = 0; i < nlocals; i++) {
+      char *name = local_name(globals, nglobals, locals, f, i);
+      found += symtab_lookup_at(&tab, name, 1) != NULL;
+      symtab_insert(&tab, name, 1);
+    }
+    for (int i = 0; i < nlocals; i++) {
+      found += symtab_lookup(&tab, locals[i]) != NULL;
+      found += symtab_lookup(&tab, globals[(f + i * 7) % nglobals]) != NULL;
+    }
+    symtab_pop(&tab);
+  }
+
+  symtab_free(&tab);
+  return found;
+}
+
+struct listentry {
+  char *name;
+  struct listentry *next;
+} typedef ListEntry;
+
+ListEntry *list_find(ListEntry *list, char *name) {
+  for (; list != NULL; list = list->next) {
+    if (list->name == name) {
+      return list;
+    }
+  }
+  return NULL;
+}
+
+ListEntry *list_push(ListEntry *list, char *name) {
+  ListEntry *entry = malloc(sizeof(ListEntry));
+  entry->name = name;
+  entry->next = list;
+  return entry;
+}
+
+void list_free(ListEntry *list) {
+  while (list != NULL) {
+    ListEntry *next = list->next;
+    free(list);
+    list = next;
+  }
+}
+
+/*
+ * run_lists() - the same workload on a global and a local list, searched
+ *               the way getentry() searched them
+ */
+long run_lists(char **globals, int nglobals, char **locals, int nfuncs,
+               int nlocals) {
+  ListEntry *globl = NULL;
+  long found = 0;
+
+  for (int i = 0; i < nglobals; i++) {
+    found += list_find(globl, globals[i]) != NULL;
+    globl = list_push(globl, globals[i]);
+  }
+
+  for (int f = 0; f < nfuncs; f++) {
+    ListEntry *local = NULL;
+    for (int i = 0; i < nlocals; i++) {
+      char *name = local_name(globals, nglobals, locals, f, i);
+      found += list_find(local, name) != NULL;
+      local = list_push(local, name);
+    }
+    for (int i = 0; i < nlocals; i++) {
+      char *a = locals[i];
+      char *b = globals[(f + i * 7) % nglobals];
+      found += (list_find(local, a) ?: list_find(globl, a)) != NULL;
+      found += (list_find(local, b) ?: list_find(globl, b)) != NULL;
+    }
+    list_free(local);
+  }
+
+  list_free(globl);
+  return found;
+}
+
+/*
+ * write_program() - writes the workload as a C-- program: the globals, then
+ *                   functions declaring the locals and assigning to names
+ */
+void write_program(char *path, char **globals, int nglobals, char **locals,
+                   int nfuncs, int nlocals) {
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    perror(path);
+    exit(1);
+  }
+
+  for (int i = 0; i < nglobals; i++) {
+    fprintf(fp, "int %s;\n", globals[i]);
+  }
+  for (int f = 0; f < nfuncs; f++) {
+    fprintf(fp, "int f%d() {\n", f);
+    for (int i = 0; i < nlocals; i++) {
+      char *name = local_name(globals, nglobals, locals, f, i);
+      fprintf(fp, "  int %s;\n", name);
+    }
+    for (int i = 0; i < nlocals; i++) {
+      fprintf(fp, "  %s = %s;\n", locals[i % 10 ? i : 1],
+              globals[(f + i * 7) % nglobals]);
+    }
+    fprintf(fp, "}\n");
+  }
+  fclose(fp);
+}
+
+int main(int argc, char *argv[]) {
+  int lists = 0;
+  char *program = NULL;
+  int argi = 1;
+
+  for (; argi < argc && argv[argi][0] == '-'; argi++) {
+    if (!strcmp(argv[argi], "-l")) {
+      lists = 1;
+    } else if (!strcmp(argv[argi], "-g") && argi + 1 < argc) {
+      program = argv[++argi];
+    }
+  }
+  int nglobals = argi < argc ? atoi(argv[argi++]) : 100000;
+  int nfuncs = argi < argc ? atoi(argv[argi++]) : 200;
+  int nlocals = argi < argc ? atoi(argv[argi++]) : 5000;
+
+  InternPool pool;
+  intern_init(&pool);
+  char **globals = make_names(&pool, "g", nglobals);
+  char **locals = make_names(&pool, "l", nlocals);
+
+  printf("%d globals, %d functions of %d locals\n", nglobals, nfuncs,
+         nlocals);
+
+  double start = now();
+  long found = run_symtab(globals, nglobals, locals, nfuncs, nlocals);
+  printf("symtab  %10.3f s  (%ld found)\n", now() - start, found);
+
+  if (lists) {
+    start = now();
+    long lfound = run_lists(globals, nglobals, locals, nfuncs, nlocals);
+    printf("lists   %10.3f s  (%ld found)\n", now() - start, lfound);
+    if (lfound != found) {
+      fprintf(stderr, "symbench: the lists found different entries\n");
+      return 1;
+    }
+  }
+
+  if (program != NULL) {
+    write_program(program, globals, nglobals, locals, nfuncs, nlocals);
+  }
+  intern_free(&pool);
+  return 0;
+}
@@ -7,16 +7,27 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 extern int parse();
 extern int chk_decl_flag;
 extern int print_ast_flag;
 extern int gen_code_flag;
+extern int keep_ast_flag;
+extern int compact_ast_flag;
+extern int ll1_flag;
+extern int max_errors;
+extern int defer_calls_flag;
 
 int chk_decl_flag = 0;  /* set to 1 to do semantic checking */
 int print_ast_flag = 0; /* set to 1 to print out the AST */
 int gen_code_flag = 0;  /* set to 1 to generate code */
+int keep_ast_flag = 0;  /* set to 1 to keep every function's AST */
+int compact_ast_flag = 0; /* set to 1 to store ASTs in compact form */
+int ll1_flag = 0;       /* set to 1 to only check syntax, by the LL(1) table */
+int max_errors = 1;     /* errors to report before stopping */
+int defer_calls_flag = 0; /* set to 1 to check calls at the end of the input */
 
 /*
  * parse_args() -- parse command-line arguments and set flags appropriately
@@ -25,6 +36,15 @@ int gen_code_flag = 0;  /* set to 1 to generate code */
  *    --chk_decl     : to check legality of declarations
  *    --print_ast    : to print out the AST of each function
  *    --gen_code     : to generate code
+ *    --keep_ast     : to keep the AST of every function until the end
+ *    --compact_ast  : to store each AST in compact arrays of indices
+ *    --ll1          : to only check syntax, with the table-driven parser;
+ *                     it cannot be combined with --chk_decl, --print_ast
+ *                     or --gen_code, which need the recursive descent parser
+ *    --max_errors N : to recover from errors and report up to N of them,
+ *                     in source order, rather than stop at the first
+ *    --defer_calls  : with --chk_decl, to allow calls to functions defined
+ *                     later, checking them once the whole input is parsed
  */
 void parse_args(int argc, char *argv[]) {
   int i;
@@ -36,11 +56,26 @@ void parse_args(int argc, char *argv[]) {
         print_ast_flag = 1;
       } else if (strcmp(argv[i], "--gen_code") == 0) {
         gen_code_flag = 1;
+      } else if (strcmp(argv[i], "--keep_ast") == 0) {
+        keep_ast_flag = 1;
+      } else if (strcmp(argv[i], "--compact_ast") == 0) {
+        compact_ast_flag = 1;
+      } else if (strcmp(argv[i], "--ll1") == 0) {
+        ll1_flag = 1;
+      } else if (strcmp(argv[i], "--max_errors") == 0 && i + 1 < argc) {
+        max_errors = atoi(argv[++i]);
+      } else if (strcmp(argv[i], "--defer_calls") == 0) {
+        defer_calls_flag = 1;
       } else {
         fprintf(stderr, "Unrecognized option: %s\n", argv[i]);
       }
     }
   }
+  if (ll1_flag && (chk_decl_flag || print_ast_flag || gen_code_flag)) {
+    fprintf(stderr, "--ll1 only checks syntax; it cannot be used with "
+                    "--chk_decl, --print_ast or --gen_code\n");
+    exit(1);
+  }
 }
 
 int main(int argc, char *argv[]) {
@@ -84,18 +84,34 @@ void Init()
   Follow(Start) = p_add(NULL, sym_insert("<EOF>", TRUE));
 }
 
+/**********************************************************************
+ * yywrap() tells the scanner there is no more input after the end of *
+ * the grammar file, so gff does not need to link with -lfl.          *
+ **********************************************************************/
+
+int yywrap()
+{
+  return 1;
+}
+
 int main(int argc, char *argv[])
 {
   FILE *fp;
+  int table = FALSE;   /* -c: write the LL(1) predict table as C source */
+  char *file;
 
-  if (argc != 2) {
-    fprintf(stderr, "Usage: %s file\n", argv[0]);
+  if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+    table = TRUE;
+  }
+  else if (argc != 2) {
+    fprintf(stderr, "Usage: %s [-c] file\n", argv[0]);
     exit(-1);
   }
+  file = argv[argc-1];
 
-  fp = fopen(argv[1], "r");
+  fp = fopen(file, "r");
   if (!fp) {
-    perror(argv[1]);
+    perror(file);
     exit(-1);
   }
 
@@ -122,7 +138,12 @@ int main(int argc, char *argv[])
 
   CompFollow();
 
-  PrintSets();
+  if (table) {
+    PrintTable(file);
+  }
+  else {
+    PrintSets();
+  }
 
   return 0;
 }
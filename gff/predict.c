@@ -0,0 +1,219 @@
+/*
+ * File: predict.c
+ * Author: Edward Fattell
+ * Purpose: Compute LL(1) predict sets and write them out as a C table
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "global.h"
+#include "symbols.h"
+#include "proto.h"
+
+extern symptr SymList;
+extern symptr Epsilon;
+extern symptr Start;
+
+/**********************************************************************
+ * GetPredict() returns the predict set of the production A -> body:  *
+ * FIRST(body) without epsilon, plus FOLLOW(A) if body is nullable.   *
+ **********************************************************************/
+
+pptr GetPredict(symptr A, pptr body)
+{
+  pptr pred = NULL;
+  pptr s0;
+
+  for (s0 = GetFirst(body); s0; s0 = Next(s0)) {
+    if (Sym(s0) == Epsilon) continue;
+    if (!p_lookup(pred, Sym(s0))) {
+      pred = p_add(pred, Sym(s0));
+    }
+  }
+
+  if (is_nullable(body)) {
+    for (s0 = Follow(A); s0; s0 = Next(s0)) {
+      if (!p_lookup(pred, Sym(s0))) {
+	pred = p_add(pred, Sym(s0));
+      }
+    }
+  }
+
+  return pred;
+}
+
+/**********************************************************************
+ * CName() returns the C expression for a grammar symbol in the table *
+ * written by PrintTable(): terminals keep their names, so a '(' is   *
+ * the character constant, the end marker is LL1_EOF, and             *
+ * nonterminals become NT_<name>.                                     *
+ **********************************************************************/
+
+char *CName(symptr sptr)
+{
+  static char buf[256];
+
+  if (strcmp(Name(sptr), "<EOF>") == 0) {
+    return "LL1_EOF";
+  }
+  if (Terminal(sptr)) {
+    return Name(sptr);
+  }
+  snprintf(buf, sizeof(buf), "NT_%s", Name(sptr));
+  return buf;
+}
+
+/**********************************************************************
+ * BodyLen() returns the number of symbols in a production body, not  *
+ * counting epsilon.                                                  *
+ **********************************************************************/
+
+int BodyLen(pptr body)
+{
+  int len = 0;
+
+  for (; body; body = Next(body)) {
+    len += Sym(body) != Epsilon;
+  }
+  return len;
+}
+
+/**********************************************************************
+ * PrintTable() writes the LL(1) predict table of the grammar as C    *
+ * source on stdout.  Productions are numbered from 1 in the order    *
+ * they appear; ll1_predict[A][t] names the production to expand the  *
+ * nonterminal A by when the lookahead is t, and 0 means a syntax     *
+ * error.  Where the grammar is not LL(1) it warns on stderr and      *
+ * keeps the production listed first, which e.g. binds an else to the *
+ * nearest if.                                                        *
+ **********************************************************************/
+
+void PrintTable(char *grammar)
+{
+  symptr sptr;
+  plist pl, pl0;
+  pptr *pred, s0;
+  int nnonterms = 0, nprods = 0, pos, p, p0;
+  char *sep;
+
+  for (sptr = SymList; sptr; sptr = Next(sptr)) {
+    if (Terminal(sptr)) continue;
+    nnonterms++;
+    for (pl = Prods(sptr); pl; pl = Next(pl)) {
+      nprods++;
+    }
+  }
+
+  pred = (pptr *) malloc(sizeof(pptr) * (nprods + 1));
+  if (!pred) ERROR("Out of memory!");
+
+  p = 1;
+  for (sptr = SymList; sptr; sptr = Next(sptr)) {
+    if (Terminal(sptr)) continue;
+    for (pl = Prods(sptr); pl; pl = Next(pl)) {
+      pred[p++] = GetPredict(sptr, Prod(pl));
+    }
+  }
+
+  printf("/*\n"
+	 " * Purpose: LL(1) predict table generated by gff -c from %s.\n"
+	 " *          Do not edit; regenerate it from the grammar instead.\n"
+	 " */\n\n", grammar);
+  printf("#define LL1_NTERMS 256\n");
+  printf("#define LL1_NNONTERMS %d\n", nnonterms);
+  printf("#define LL1_NPRODS %d\n\n", nprods);
+
+  /*
+   * nonterminals are numbered after the terminals, so a single short can
+   * hold any grammar symbol.
+   */
+  printf("enum {\n");
+  pos = 0;
+  for (sptr = SymList; sptr; sptr = Next(sptr)) {
+    if (Terminal(sptr)) continue;
+    if (pos++ == 0) {
+      printf("  %s = LL1_NTERMS,\n", CName(sptr));
+    }
+    else {
+      printf("  %s,\n", CName(sptr));
+    }
+  }
+  printf("};\n\n");
+  printf("#define LL1_START %s\n\n", CName(Start));
+
+  printf("static const char *ll1_ntname[LL1_NNONTERMS] = {\n");
+  for (sptr = SymList; sptr; sptr = Next(sptr)) {
+    if (Terminal(sptr)) continue;
+    printf("  \"%s\",\n", Name(sptr));
+  }
+  printf("};\n\n");
+
+  /*
+   * the bodies, back to back: production p is ll1_rhs[ll1_rhs_start[p]]
+   * up to ll1_rhs[ll1_rhs_start[p + 1]].
+   */
+  printf("static const short ll1_rhs[] = {\n");
+  p = 1;
+  for (sptr = SymList; sptr; sptr = Next(sptr)) {
+    if (Terminal(sptr)) continue;
+    for (pl = Prods(sptr); pl; pl = Next(pl)) {
+      printf("  /* %d: %s ->", p++, Name(sptr));
+      for (s0 = Prod(pl); s0; s0 = Next(s0)) {
+	if (Sym(s0) != Epsilon) printf(" %s", Name(Sym(s0)));
+      }
+      printf(" */\n");
+      if (BodyLen(Prod(pl)) == 0) continue;
+      printf(" ");
+      for (s0 = Prod(pl); s0; s0 = Next(s0)) {
+	if (Sym(s0) != Epsilon) printf(" %s,", CName(Sym(s0)));
+      }
+      printf("\n");
+    }
+  }
+  printf("  0\n};\n\n");
+
+  printf("static const short ll1_rhs_start[LL1_NPRODS + 2] = {\n  0,");
+  pos = 0;
+  for (sptr = SymList; sptr; sptr = Next(sptr)) {
+    if (Terminal(sptr)) continue;
+    for (pl = Prods(sptr); pl; pl = Next(pl)) {
+      printf(" %d,", pos);
+      pos += BodyLen(Prod(pl));
+    }
+  }
+  printf(" %d\n};\n\n", pos);
+
+  printf("static const %s ll1_predict[LL1_NNONTERMS][LL1_NTERMS] = {\n",
+	 nprods < 256 ? "unsigned char" : "short");
+  p = 1;
+  for (sptr = SymList; sptr; sptr = Next(sptr)) {
+    if (Terminal(sptr)) continue;
+    printf("  [%s - LL1_NTERMS] = {", CName(sptr));
+    sep = "";
+    p0 = p;
+    for (pl = Prods(sptr); pl; pl = Next(pl), p++) {
+      for (s0 = pred[p]; s0; s0 = Next(s0)) {
+	/*
+	 * an earlier production of the same nonterminal that predicts
+	 * this terminal too wins.
+	 */
+	int q = p0;
+	for (pl0 = Prods(sptr); pl0 != pl; pl0 = Next(pl0), q++) {
+	  if (p_lookup(pred[q], Sym(s0))) break;
+	}
+	if (pl0 != pl) {
+	  fprintf(stderr, "WARNING: LL(1) conflict for %s on %s: using production %d, not %d\n",
+		  Name(sptr), Name(Sym(s0)), q, p);
+	  continue;
+	}
+	printf("%s[%s] = %d", sep, CName(Sym(s0)), p);
+	sep = ", ";
+      }
+    }
+    printf("},\n");
+  }
+  printf("};\n");
+
+  free(pred);
+}
@@ -14,3 +14,6 @@ pptr GetFirst(pptr L);
 void CompFollow();
 
 void PrintSets();
+
+pptr GetPredict(symptr A, pptr body);
+void PrintTable(char *grammar);
@@ -0,0 +1,138 @@
+/*
+ * Author: Edward Fattell
+ * File: intern.c
+ * Purpose: String interning pool shared by the scanner and parser
+ */
+#include "intern.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_CHUNK 65536
+
+/*
+ * internchunk holds the bytes of interned strings; chunks are never moved,
+ * which keeps every handle stable for the life of the pool
+ */
+struct internchunk {
+  struct internchunk *next;
+  int used;
+  int size;
+  char text[];
+};
+
+/*
+ * hash_bytes() - FNV-1a hash of len bytes
+ */
+unsigned hash_bytes(const char *text, int len) {
+  unsigned h = 2166136261u;
+
+  for (int i = 0; i < len; i++) {
+    h ^= (unsigned char)text[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+void intern_init(InternPool *pool) {
+  pool->count = 0;
+  pool->cap = 256;
+  pool->names = malloc(sizeof(char *) * pool->cap);
+  pool->hashes = malloc(sizeof(unsigned) * pool->cap);
+  pool->nslots = 512;
+  pool->slots = calloc(pool->nslots, sizeof(int));
+  pool->chunks = NULL;
+}
+
+void intern_free(InternPool *pool) {
+  struct internchunk *next;
+
+  while (pool->chunks != NULL) {
+    next = pool->chunks->next;
+    free(pool->chunks);
+    pool->chunks = next;
+  }
+  free(pool->names);
+  free(pool->hashes);
+  free(pool->slots);
+  pool->names = NULL;
+  pool->hashes = NULL;
+  pool->slots = NULL;
+  pool->count = 0;
+}
+
+/*
+ * store() - copies len bytes plus a terminating NUL into chunk storage
+ */
+char *store(InternPool *pool, const char *text, int len) {
+  struct internchunk *chunk = pool->chunks;
+
+  if (chunk == NULL || chunk->used + len + 1 > chunk->size) {
+    int size = len + 1 > INTERN_CHUNK ? len + 1 : INTERN_CHUNK;
+    chunk = malloc(sizeof(struct internchunk) + size);
+    chunk->used = 0;
+    chunk->size = size;
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+  }
+
+  char *name = chunk->text + chunk->used;
+  memcpy(name, text, len);
+  name[len] = '\0';
+  chunk->used += len + 1;
+  return name;
+}
+
+/*
+ * grow_slots() - doubles the hash table and reinserts every id
+ */
+void grow_slots(InternPool *pool) {
+  free(pool->slots);
+  pool->nslots *= 2;
+  pool->slots = calloc(pool->nslots, sizeof(int));
+
+  int mask = pool->nslots - 1;
+  for (int id = 0; id < pool->count; id++) {
+    int i = pool->hashes[id] & mask;
+    while (pool->slots[i]) {
+      i = (i + 1) & mask;
+    }
+    pool->slots[i] = id + 1;
+  }
+}
+
+int intern(InternPool *pool, const char *text, int len) {
+  unsigned h = hash_bytes(text, len);
+  int mask = pool->nslots - 1;
+  int i = h & mask;
+
+  // linear probe until the name or an empty slot is found
+  while (pool->slots[i]) {
+    int id = pool->slots[i] - 1;
+    if (pool->hashes[id] == h && !strncmp(pool->names[id], text, len) &&
+        pool->names[id][len] == '\0') {
+      return id;
+    }
+    i = (i + 1) & mask;
+  }
+
+  if (pool->count == pool->cap) {
+    pool->cap *= 2;
+    pool->names = realloc(pool->names, sizeof(char *) * pool->cap);
+    pool->hashes = realloc(pool->hashes, sizeof(unsigned) * pool->cap);
+  }
+
+  int id = pool->count++;
+  pool->names[id] = store(pool, text, len);
+  pool->hashes[id] = h;
+  pool->slots[i] = id + 1;
+
+  // keep the table at most half full
+  if (pool->count * 2 > pool->nslots) {
+    grow_slots(pool);
+  }
+  return id;
+}
+
+char *intern_name(InternPool *pool, int id) {
+  return pool->names[id];
+}
@@ -0,0 +1,40 @@
+/*
+ * File: intern.h
+ * Author: Edward Fattell
+ * Purpose: String interning pool.  Each distinct name is stored once and
+ *          given a small integer id; the stored string is a stable handle,
+ *          so two interned names are equal exactly when their pointers are.
+ */
+
+#ifndef __INTERN_H__
+#define __INTERN_H__
+
+struct internpool {
+  char **names;       /* id -> interned string */
+  unsigned *hashes;   /* id -> hash of that string */
+  int count;          /* number of interned strings */
+  int cap;            /* capacity of names and hashes */
+  int *slots;         /* open-addressed hash table of id + 1, 0 if empty */
+  int nslots;         /* size of slots, a power of two */
+  struct internchunk *chunks; /* storage for the string bytes */
+} typedef InternPool;
+
+/*
+ * intern_init() prepares an empty pool; intern_free() releases everything in
+ * it, after which no handle from the pool may be used.
+ */
+void intern_init(InternPool *pool);
+void intern_free(InternPool *pool);
+
+/*
+ * intern() returns the id of the len bytes at text, adding them to the pool
+ * if they are not there yet.  text need not be NUL-terminated.
+ */
+int intern(InternPool *pool, const char *text, int len);
+
+/*
+ * intern_name() returns the NUL-terminated handle for an id from intern().
+ */
+char *intern_name(InternPool *pool, int id);
+
+#endif /* __INTERN_H__ */
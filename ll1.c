@@ -0,0 +1,65 @@
+/*
+ * Author: Edward Fattell
+ * File: ll1.c
+ * Purpose: Table-driven LL(1) recognizer for C--
+ */
+#include "ll1.h"
+#include <stdlib.h>
+
+#define LL1_EOF TOK_EOF
+#include "ll1tab.h"
+
+int ll1_parse(const TokenBuf *toks, int *expected) {
+  int cap = 256;
+  short *stack = malloc(sizeof(short) * cap);
+  int top = 0;
+  int i = 0;
+  int bad = -1;
+
+  stack[top++] = LL1_EOF;
+  stack[top++] = LL1_START;
+
+  while (top > 0) {
+    int sym = stack[--top];
+    int tok = toks->kind[i];
+
+    // a terminal on top must be the next token
+    if (sym < LL1_NTERMS) {
+      if (sym != tok) {
+        bad = i;
+        *expected = sym;
+        break;
+      }
+      i++;
+      continue;
+    }
+
+    // a nonterminal is replaced by the body the table predicts, pushed
+    // last symbol first so that the first is on top
+    int p = ll1_predict[sym - LL1_NTERMS][tok];
+    if (p == 0) {
+      bad = i;
+      *expected = sym;
+      break;
+    }
+    int start = ll1_rhs_start[p];
+    int end = ll1_rhs_start[p + 1];
+    if (top + end - start > cap) {
+      cap *= 2;
+      stack = realloc(stack, sizeof(short) * cap);
+    }
+    while (end > start) {
+      stack[top++] = ll1_rhs[--end];
+    }
+  }
+
+  free(stack);
+  return bad;
+}
+
+const char *ll1_name(int sym) {
+  if (sym < LL1_NTERMS) {
+    return NULL;
+  }
+  return ll1_ntname[sym - LL1_NTERMS];
+}
@@ -0,0 +1,29 @@
+/*
+ * File: ll1.h
+ * Author: Edward Fattell
+ * Purpose: Table-driven LL(1) recognizer for C--.  It runs on the predict
+ *          table that gff -c generates from cmm.txt into ll1tab.h, with an
+ *          explicit stack of grammar symbols in place of recursion.
+ */
+
+#ifndef __LL1_H__
+#define __LL1_H__
+
+#include "scanner.h"
+
+/*
+ * ll1_parse() checks that toks, scanned through its TOK_EOF entry, spells a
+ * C-- program.  It returns -1 if so, or else the index of the first token
+ * the table has no move for, with the grammar symbol it was looking for in
+ * *expected.  It checks syntax only: no symbol table is kept and no AST is
+ * built.
+ */
+int ll1_parse(const TokenBuf *toks, int *expected);
+
+/*
+ * ll1_name() returns the name of a nonterminal from *expected, or NULL if
+ * the symbol is a terminal, whose value is its Token (or TOK_EOF).
+ */
+const char *ll1_name(int sym);
+
+#endif /* __LL1_H__ */
@@ -0,0 +1,207 @@
+/*
+ * Purpose: LL(1) predict table generated by gff -c from cmm.txt.
+ *          Do not edit; regenerate it from the grammar instead.
+ */
+
+#define LL1_NTERMS 256
+#define LL1_NNONTERMS 26
+#define LL1_NPRODS 59
+
+enum {
+  NT_and_exp = LL1_NTERMS,
+  NT_and_rest,
+  NT_arith_exp,
+  NT_arith_rest,
+  NT_bool_exp,
+  NT_decl_or_func,
+  NT_expr_list_rest,
+  NT_factor,
+  NT_formals_rest,
+  NT_id_list_rest,
+  NT_id_rest,
+  NT_id_stmt,
+  NT_opt_else,
+  NT_opt_expr_list,
+  NT_opt_formals,
+  NT_opt_return,
+  NT_opt_stmt_list,
+  NT_opt_var_decls,
+  NT_or_rest,
+  NT_prog,
+  NT_rel_exp,
+  NT_rel_rest,
+  NT_relop,
+  NT_stmt,
+  NT_term,
+  NT_term_rest,
+};
+
+#define LL1_START NT_prog
+
+static const char *ll1_ntname[LL1_NNONTERMS] = {
+  "and_exp",
+  "and_rest",
+  "arith_exp",
+  "arith_rest",
+  "bool_exp",
+  "decl_or_func",
+  "expr_list_rest",
+  "factor",
+  "formals_rest",
+  "id_list_rest",
+  "id_rest",
+  "id_stmt",
+  "opt_else",
+  "opt_expr_list",
+  "opt_formals",
+  "opt_return",
+  "opt_stmt_list",
+  "opt_var_decls",
+  "or_rest",
+  "prog",
+  "rel_exp",
+  "rel_rest",
+  "relop",
+  "stmt",
+  "term",
+  "term_rest",
+};
+
+static const short ll1_rhs[] = {
+  /* 1: and_exp -> rel_exp and_rest */
+  NT_rel_exp, NT_and_rest,
+  /* 2: and_rest -> opAND rel_exp and_rest */
+  opAND, NT_rel_exp, NT_and_rest,
+  /* 3: and_rest -> */
+  /* 4: arith_exp -> term arith_rest */
+  NT_term, NT_arith_rest,
+  /* 5: arith_rest -> opADD term arith_rest */
+  opADD, NT_term, NT_arith_rest,
+  /* 6: arith_rest -> opSUB term arith_rest */
+  opSUB, NT_term, NT_arith_rest,
+  /* 7: arith_rest -> */
+  /* 8: bool_exp -> and_exp or_rest */
+  NT_and_exp, NT_or_rest,
+  /* 9: decl_or_func -> LPAREN opt_formals RPAREN LBRACE opt_var_decls opt_stmt_list RBRACE */
+  LPAREN, NT_opt_formals, RPAREN, LBRACE, NT_opt_var_decls, NT_opt_stmt_list, RBRACE,
+  /* 10: decl_or_func -> id_list_rest SEMI */
+  NT_id_list_rest, SEMI,
+  /* 11: expr_list_rest -> COMMA arith_exp expr_list_rest */
+  COMMA, NT_arith_exp, NT_expr_list_rest,
+  /* 12: expr_list_rest -> */
+  /* 13: factor -> opSUB factor */
+  opSUB, NT_factor,
+  /* 14: factor -> LPAREN bool_exp RPAREN */
+  LPAREN, NT_bool_exp, RPAREN,
+  /* 15: factor -> INTCON */
+  INTCON,
+  /* 16: factor -> ID id_rest */
+  ID, NT_id_rest,
+  /* 17: formals_rest -> COMMA kwINT ID formals_rest */
+  COMMA, kwINT, ID, NT_formals_rest,
+  /* 18: formals_rest -> */
+  /* 19: id_list_rest -> COMMA ID id_list_rest */
+  COMMA, ID, NT_id_list_rest,
+  /* 20: id_list_rest -> */
+  /* 21: id_rest -> LPAREN opt_expr_list RPAREN */
+  LPAREN, NT_opt_expr_list, RPAREN,
+  /* 22: id_rest -> */
+  /* 23: id_stmt -> opASSG arith_exp SEMI */
+  opASSG, NT_arith_exp, SEMI,
+  /* 24: id_stmt -> LPAREN opt_expr_list RPAREN SEMI */
+  LPAREN, NT_opt_expr_list, RPAREN, SEMI,
+  /* 25: opt_else -> kwELSE stmt */
+  kwELSE, NT_stmt,
+  /* 26: opt_else -> */
+  /* 27: opt_expr_list -> arith_exp expr_list_rest */
+  NT_arith_exp, NT_expr_list_rest,
+  /* 28: opt_expr_list -> */
+  /* 29: opt_formals -> kwINT ID formals_rest */
+  kwINT, ID, NT_formals_rest,
+  /* 30: opt_formals -> */
+  /* 31: opt_return -> arith_exp */
+  NT_arith_exp,
+  /* 32: opt_return -> */
+  /* 33: opt_stmt_list -> stmt opt_stmt_list */
+  NT_stmt, NT_opt_stmt_list,
+  /* 34: opt_stmt_list -> */
+  /* 35: opt_var_decls -> kwINT ID id_list_rest SEMI opt_var_decls */
+  kwINT, ID, NT_id_list_rest, SEMI, NT_opt_var_decls,
+  /* 36: opt_var_decls -> */
+  /* 37: or_rest -> opOR and_exp or_rest */
+  opOR, NT_and_exp, NT_or_rest,
+  /* 38: or_rest -> */
+  /* 39: prog -> kwINT ID decl_or_func prog */
+  kwINT, ID, NT_decl_or_func, NT_prog,
+  /* 40: prog -> */
+  /* 41: rel_exp -> arith_exp rel_rest */
+  NT_arith_exp, NT_rel_rest,
+  /* 42: rel_rest -> relop arith_exp */
+  NT_relop, NT_arith_exp,
+  /* 43: rel_rest -> */
+  /* 44: relop -> opEQ */
+  opEQ,
+  /* 45: relop -> opNE */
+  opNE,
+  /* 46: relop -> opGT */
+  opGT,
+  /* 47: relop -> opGE */
+  opGE,
+  /* 48: relop -> opLT */
+  opLT,
+  /* 49: relop -> opLE */
+  opLE,
+  /* 50: stmt -> ID id_stmt */
+  ID, NT_id_stmt,
+  /* 51: stmt -> kwWHILE LPAREN bool_exp RPAREN stmt */
+  kwWHILE, LPAREN, NT_bool_exp, RPAREN, NT_stmt,
+  /* 52: stmt -> kwIF LPAREN bool_exp RPAREN stmt opt_else */
+  kwIF, LPAREN, NT_bool_exp, RPAREN, NT_stmt, NT_opt_else,
+  /* 53: stmt -> kwRETURN opt_return SEMI */
+  kwRETURN, NT_opt_return, SEMI,
+  /* 54: stmt -> LBRACE opt_stmt_list RBRACE */
+  LBRACE, NT_opt_stmt_list, RBRACE,
+  /* 55: stmt -> SEMI */
+  SEMI,
+  /* 56: term -> factor term_rest */
+  NT_factor, NT_term_rest,
+  /* 57: term_rest -> opMUL factor term_rest */
+  opMUL, NT_factor, NT_term_rest,
+  /* 58: term_rest -> opDIV factor term_rest */
+  opDIV, NT_factor, NT_term_rest,
+  /* 59: term_rest -> */
+  0
+};
+
+static const short ll1_rhs_start[LL1_NPRODS + 2] = {
+  0, 0, 2, 5, 5, 7, 10, 13, 13, 15, 22, 24, 27, 27, 29, 32, 33, 35, 39, 39, 42, 42, 45, 45, 48, 52, 54, 54, 56, 56, 59, 59, 60, 60, 62, 62, 67, 67, 70, 70, 74, 74, 76, 78, 78, 79, 80, 81, 82, 83, 84, 86, 91, 97, 100, 103, 104, 106, 109, 112, 112
+};
+
+static const unsigned char ll1_predict[LL1_NNONTERMS][LL1_NTERMS] = {
+  [NT_and_exp - LL1_NTERMS] = {[opSUB] = 1, [LPAREN] = 1, [INTCON] = 1, [ID] = 1},
+  [NT_and_rest - LL1_NTERMS] = {[opAND] = 2, [opOR] = 3, [RPAREN] = 3},
+  [NT_arith_exp - LL1_NTERMS] = {[opSUB] = 4, [LPAREN] = 4, [INTCON] = 4, [ID] = 4},
+  [NT_arith_rest - LL1_NTERMS] = {[opADD] = 5, [opSUB] = 6, [COMMA] = 7, [SEMI] = 7, [RPAREN] = 7, [opEQ] = 7, [opNE] = 7, [opGT] = 7, [opGE] = 7, [opLT] = 7, [opLE] = 7, [opAND] = 7, [opOR] = 7},
+  [NT_bool_exp - LL1_NTERMS] = {[opSUB] = 8, [LPAREN] = 8, [INTCON] = 8, [ID] = 8},
+  [NT_decl_or_func - LL1_NTERMS] = {[LPAREN] = 9, [COMMA] = 10, [SEMI] = 10},
+  [NT_expr_list_rest - LL1_NTERMS] = {[COMMA] = 11, [RPAREN] = 12},
+  [NT_factor - LL1_NTERMS] = {[opSUB] = 13, [LPAREN] = 14, [INTCON] = 15, [ID] = 16},
+  [NT_formals_rest - LL1_NTERMS] = {[COMMA] = 17, [RPAREN] = 18},
+  [NT_id_list_rest - LL1_NTERMS] = {[COMMA] = 19, [SEMI] = 20},
+  [NT_id_rest - LL1_NTERMS] = {[LPAREN] = 21, [opMUL] = 22, [opDIV] = 22, [opADD] = 22, [opSUB] = 22, [COMMA] = 22, [SEMI] = 22, [RPAREN] = 22, [opEQ] = 22, [opNE] = 22, [opGT] = 22, [opGE] = 22, [opLT] = 22, [opLE] = 22, [opAND] = 22, [opOR] = 22},
+  [NT_id_stmt - LL1_NTERMS] = {[opASSG] = 23, [LPAREN] = 24},
+  [NT_opt_else - LL1_NTERMS] = {[kwELSE] = 25, [ID] = 26, [kwWHILE] = 26, [kwIF] = 26, [kwRETURN] = 26, [LBRACE] = 26, [SEMI] = 26, [RBRACE] = 26},
+  [NT_opt_expr_list - LL1_NTERMS] = {[opSUB] = 27, [LPAREN] = 27, [INTCON] = 27, [ID] = 27, [RPAREN] = 28},
+  [NT_opt_formals - LL1_NTERMS] = {[kwINT] = 29, [RPAREN] = 30},
+  [NT_opt_return - LL1_NTERMS] = {[opSUB] = 31, [LPAREN] = 31, [INTCON] = 31, [ID] = 31, [SEMI] = 32},
+  [NT_opt_stmt_list - LL1_NTERMS] = {[ID] = 33, [kwWHILE] = 33, [kwIF] = 33, [kwRETURN] = 33, [LBRACE] = 33, [SEMI] = 33, [RBRACE] = 34},
+  [NT_opt_var_decls - LL1_NTERMS] = {[kwINT] = 35, [ID] = 36, [kwWHILE] = 36, [kwIF] = 36, [kwRETURN] = 36, [LBRACE] = 36, [SEMI] = 36, [RBRACE] = 36},
+  [NT_or_rest - LL1_NTERMS] = {[opOR] = 37, [RPAREN] = 38},
+  [NT_prog - LL1_NTERMS] = {[kwINT] = 39, [LL1_EOF] = 40},
+  [NT_rel_exp - LL1_NTERMS] = {[opSUB] = 41, [LPAREN] = 41, [INTCON] = 41, [ID] = 41},
+  [NT_rel_rest - LL1_NTERMS] = {[opEQ] = 42, [opNE] = 42, [opGT] = 42, [opGE] = 42, [opLT] = 42, [opLE] = 42, [opAND] = 43, [opOR] = 43, [RPAREN] = 43},
+  [NT_relop - LL1_NTERMS] = {[opEQ] = 44, [opNE] = 45, [opGT] = 46, [opGE] = 47, [opLT] = 48, [opLE] = 49},
+  [NT_stmt - LL1_NTERMS] = {[ID] = 50, [kwWHILE] = 51, [kwIF] = 52, [kwRETURN] = 53, [LBRACE] = 54, [SEMI] = 55},
+  [NT_term - LL1_NTERMS] = {[opSUB] = 56, [LPAREN] = 56, [INTCON] = 56, [ID] = 56},
+  [NT_term_rest - LL1_NTERMS] = {[opMUL] = 57, [opDIV] = 58, [opADD] = 59, [opSUB] = 59, [COMMA] = 59, [SEMI] = 59, [RPAREN] = 59, [opEQ] = 59, [opNE] = 59, [opGT] = 59, [opGE] = 59, [opLT] = 59, [opLE] = 59, [opAND] = 59, [opOR] = 59},
+};
@@ -4,54 +4,166 @@
  * Purpose: Parser for G2, and eventually C-- compiler
  */
 #include "parser.h"
+#include "arena.h"
 #include "ast.h"
+#include "astcompact.h"
+#include "ll1.h"
 #include "scanner.h"
+#include "symtab.h"
 #include <assert.h>
+#include <limits.h>
+#include <setjmp.h>
+#include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 int curr_tok;
+char *lexeme;
+int lval;
+
+// The scanner over stdin; it owns the input and the interned names
+Scanner *scanner;
+
+// The whole token stream, scanned up front; tok_idx indexes curr_tok
+TokenBuf toks;
+int tok_idx;
+
+// Symbol table; a function's locals are in a scope pushed over the globals
+SymTab symtab;
+
+// Quads are allocated from quad_arena, which is reset after each function
+// unless --keep_ast asks for every tree to be kept; ast_root then lists the
+// FUNC_DEF trees in source order, as a STMT_LIST made at the end.  With
+// --compact_ast each tree is copied into compact_tree once it is parsed, and
+// ast_root and the trees handed to print_ast() are compact handles.
+Arena quad_arena;
+void *ast_root = NULL;
+
+// Elements of the lists being built, innermost list on top; the kept trees
+// for ast_root sit at the bottom.  Expressions keep their operands here too.
+void **scratch;
+int nscratch;
+int capscratch;
+
+// Operators of the expressions being parsed, waiting for their right
+// operands; DUMMY marks an open parenthesis
+NodeType *opstack;
+int nops;
+int capops;
+
+// Statements open around the one being parsed, innermost on top: lists
+// collecting their statements on the scratch stack, and if, else and while
+// waiting for their bodies
+enum pending { IN_LIST, IN_IF, IN_ELSE, IN_WHILE } typedef pending;
+struct stmtframe {
+  pending kind;
+  Quad *node; /* the IF or WHILE waiting */
+  int base;   /* for a list, where its statements start on scratch */
+} typedef StmtFrame;
+StmtFrame *stmtstack;
+int nstmts;
+int capstmts;
+
+// Whether a token is in the first set of stmt; EOF is -1, so the unsigned
+// comparison leaves it out
+#define STMT_FIRST                                                             \
+  (1u << ID | 1u << kwWHILE | 1u << kwIF | 1u << kwRETURN | 1u << LBRACE |     \
+   1u << SEMI)
+#define starts_stmt(t) ((unsigned)(t) < 32 && (STMT_FIRST >> (t) & 1))
+
+// With --max_errors above 1, linepexit() records each error and longjmps to
+// the innermost recovery point: opt_stmt_list() skips to the end of the
+// statement, prog() to the next int outside any function body.  The errors
+// are printed in source order once parsing ends or the limit is reached.
+struct diag {
+  long off;   /* where in the input it was found */
+  int seq;    /* order it was found in, among errors at the same offset */
+  char *text; /* the whole message, as linepexit() would print it */
+} typedef Diag;
+Diag *diags;
+int ndiags;
+int capdiags;
+jmp_buf *recover_at; /* innermost recovery point, or NULL for none */
+int top_mark;        /* nscratch when prog() began the current declaration */
+int stmt_mark;       /* nscratch when the current statement began */
+int in_body;         /* inside the braces of a function body */
+
+// With --defer_calls, a call to a name not yet declared is checked once the
+// whole input is parsed, so a function may call one defined after it.  Each
+// such name gets a stand-in entry for its call nodes to point at, as does an
+// undeclared callee when --chk_decl is off.  Stand-ins are found by hashing
+// the interned name into pend_slots; the calls wait in pend_calls in source
+// order.  At the end each call looks its callee up among the global
+// declarations once, so checking them all costs time in the calls.
+struct pendcall {
+  int tok;           /* index in toks of the callee's name */
+  int argcnt;        /* arguments passed */
+  symboltab *callee; /* stand-in for the callee's entry */
+  symboltab *decl;   /* the callee's global declaration, once resolved */
+} typedef PendCall;
+symboltab **pend_slots;
+int npend_slots; /* a power of two, or 0 before the first call */
+int pend_shift;  /* 64 - log2(npend_slots), for hashing */
+int npend_names;
+PendCall *pend_calls;
+int npend_calls;
+int cappend_calls;
 
-// Symbol Table pointers
-symboltab *globl = NULL;
-symboltab *local = NULL;
-
-Quad *ast_root = NULL;
 enum scope { GLOBAL, LOCAL, EITHER } typedef scopetype;
 scopetype curscope = GLOBAL;
 symboltab *getentry(char *id, scopetype scope);
 Quad *new_quad(NodeType t);
+void advance();
+Token peek(int n);
 void match(Token expected);
 
 // Grammar Rule Procedures
 void prog();
 void var_decl();
 void decl_or_func();
+void func_def();
 void type();
 int opt_formals(Quad **subtree);
 int formals(Quad **subtree);
 void opt_var_decls();
 void opt_stmt_list(Quad **subtree);
-void stmt(Quad **subtree);
-void if_stmt(Quad **subtree);
-void while_stmt(Quad **subtree);
+void simple_stmt(Quad **subtree);
 void return_stmt(Quad **subtree);
 void assg_stmt(Quad **subtree);
-void fn_call(Quad **subtree, char *id);
+void fn_call(Quad **subtree);
 int opt_expr_list(Quad **subtree, int expected_argcnt);
 int expr_list(Quad **subtree, int expected_argcnt);
 void bool_exp(Quad **subtree);
 void arith_exp(Quad **subtree);
-NodeType relop();
+Quad *expression(int boolean);
+Quad *operand();
 
 // Helper procedures
 void check_var(char *lexeme);
 int check_arg_count(char *lexemeLoc);
+symboltab *pend_stub(char *id);
+symboltab *defer_call(char *id, int tok);
+void resolve_calls();
 void linepexit(Token t, char *lexeme, char *str);
-void freeQuad(Quad *quad);
-void freeSymTab(symboltab *tabin);
+void list_add(void *elem);
+Quad *list_end(NodeType type, int base);
+NodeType binop(Token t, int boolean);
+int prec(NodeType op);
+int is_bool(Quad *tree);
+void push_op(NodeType op);
+void reduce();
+void push_stmt(pending kind, Quad *node);
+void keep_tree(void *tree);
+void make_ast_root();
+void ll1_check();
+void sync_top();
+int sync_stmt();
+int finish_stmt(Quad *tree, Quad **subtree, int bottom);
+void report_errors();
 void freeTabs(void);
 
 // Token Name array for printing error messages
@@ -62,59 +174,101 @@ char *token_name[] = {
     "opGT",   "opGE",  "opLT",   "opLE",   "opAND",  "opOR",    "opNOT",
 };
 
+/*
+ * scope_level() - the symbol table scope that curscope declares into
+ */
+int scope_level() {
+  return curscope == GLOBAL ? 0 : symtab.depth;
+}
+
 symboltab *createEntry(char *lexeme) {
   // check if in table first
-  symboltab **curtab = NULL;
-  if (curscope == GLOBAL) {
-    curtab = &globl;
-  } else {
-    curtab = &local;
-  }
-
   if (getentry(lexeme, curscope)) {
     linepexit(curr_tok, lexeme, "symbol previously defined.");
   }
 
-  symboltab *newHd = malloc(sizeof(symboltab));
+  symboltab *newHd = symtab_insert(&symtab, lexeme, scope_level());
   newHd->dtype = VAR;
   newHd->argcnt = 0;
-  newHd->name = strdup(lexeme);
-  newHd->next = *curtab;
-  *curtab = newHd;
   return newHd;
 }
 
 symboltab *createFuncEntry(char *lexeme, int argcnt) {
   // check if in table first
-  symboltab **curtab = &local;
-  if (curscope == GLOBAL) {
-    curtab = &globl;
-  }
-
   if (getentry(lexeme, curscope)) {
     linepexit(curr_tok, lexeme, "symbol previously defined.");
   }
 
-  symboltab *newHd = malloc(sizeof(symboltab));
+  symboltab *newHd = symtab_insert(&symtab, lexeme, scope_level());
   newHd->dtype = FUNC;
   newHd->argcnt = argcnt;
-  newHd->name = strdup(lexeme);
-  newHd->next = *curtab;
-  *curtab = newHd;
   return newHd;
 }
 
 int parse() {
   atexit(freeTabs);
-  curr_tok = get_token();
+  symtab_init(&symtab);
+  symtab.retain = keep_ast_flag && !compact_ast_flag;
+  arena_init(&quad_arena);
+  if (compact_ast_flag) {
+    compact_init(&compact_tree);
+  }
+  scanner = scanner_create(STDIN_FILENO);
+  tokbuf_init(&toks);
+  scan_all_parallel(scanner, &toks, 0);
+  if (ll1_flag) {
+    ll1_check();
+    return 0;
+  }
+  tok_idx = -1;
+  advance();
   prog();
   match(EOF);
+  resolve_calls();
+  if (ndiags > 0) {
+    report_errors();
+    exit(1);
+  }
+  if (keep_ast_flag) {
+    make_ast_root();
+  }
   return 0;
 }
 
+/*
+ * advance() - moves to the next token of the stream, loading curr_tok,
+ *             lexeme and lval from it.  Only IDs carry a lexeme string (their
+ *             interned name); linepexit() recovers any other lexeme from its
+ *             slice of the input.
+ */
+void advance() {
+  if (tok_idx + 1 < toks.count) {
+    tok_idx++;
+  }
+
+  int kind = toks.kind[tok_idx];
+  curr_tok = kind == TOK_EOF ? EOF : kind;
+  lexeme = kind == ID ? id_name(scanner, toks.val[tok_idx]) : NULL;
+  lval = kind == INTCON ? toks.val[tok_idx] : 0;
+}
+
+/*
+ * peek() - returns the token n places after curr_tok, so that peek(0) is
+ *          curr_tok, or EOF past the end of the stream.  The whole stream is
+ *          in toks, so any distance costs the same.
+ */
+Token peek(int n) {
+  int i = tok_idx + n;
+
+  if (i < 0 || i >= toks.count || toks.kind[i] == TOK_EOF) {
+    return EOF;
+  }
+  return toks.kind[i];
+}
+
 void match(Token expected) {
   if (curr_tok == expected) {
-    curr_tok = get_token();
+    advance();
   } else {
     char msg[1024];
     sprintf(msg, "match error, expected %s", token_name[expected]);
@@ -123,8 +277,17 @@ void match(Token expected) {
 }
 
 void prog() {
+  jmp_buf env;
+  jmp_buf *outer = recover_at;
+
+  if (setjmp(env)) {
+    sync_top();
+  }
+  recover_at = &env;
+
   // iterate to simulate recursion
   while (curr_tok == kwINT) {
+    top_mark = nscratch;
     match(kwINT);
     decl_or_func();
   }
@@ -134,6 +297,7 @@ void prog() {
   } else {
     linepexit(curr_tok, lexeme, "expected EOF");
   }
+  recover_at = outer;
 }
 
 void id_list_rest() {
@@ -164,18 +328,18 @@ int formals(Quad **subtree) {
   assert(*subtree == NULL);
 
   Quad *newSubtree = NULL;
-  Quad *curSubtree = NULL;
+  int base = nscratch;
 
   int formalcnt = 0;
 
   if (curr_tok == kwINT) {
-    newSubtree = new_quad(EXPR_LIST);
-    *subtree = newSubtree;
-    curSubtree = newSubtree;
     type();
 
-    curSubtree->child0 = new_quad(IDENTIFIER);
-    curSubtree->child0->tableentry = createEntry(lexeme);
+    if (curr_tok == ID) {
+      newSubtree = new_quad(IDENTIFIER);
+      newSubtree->tableentry = createEntry(lexeme);
+      list_add(newSubtree);
+    }
     match(ID);
 
     formalcnt++;
@@ -186,16 +350,17 @@ int formals(Quad **subtree) {
 
     type();
     if (curr_tok == ID) {
-      curSubtree->child1 = new_quad(EXPR_LIST);
-      curSubtree = curSubtree->child1;
-
-      curSubtree->child0 = new_quad(IDENTIFIER);
-      curSubtree->child0->tableentry = createEntry(lexeme);
+      newSubtree = new_quad(IDENTIFIER);
+      newSubtree->tableentry = createEntry(lexeme);
+      list_add(newSubtree);
     }
     match(ID);
     formalcnt++;
   }
 
+  if (formalcnt > 0) {
+    *subtree = list_end(EXPR_LIST, base);
+  }
   return formalcnt;
 }
 
@@ -207,57 +372,79 @@ int formals(Quad **subtree) {
  * child1 = body Quad
  */
 void decl_or_func() {
-  Quad *subtreeHd = NULL;
-  Quad **subtree = &subtreeHd;
+  // a name followed by ; or , is a declaration, anything else a function
+  if (peek(1) != SEMI && peek(1) != COMMA) {
+    func_def();
+    return;
+  }
 
-  char funcName[1024];
-  strcpy(funcName, lexeme);
+  char *varName = lexeme;
   match(ID);
-
-  if (curr_tok == SEMI) {
-    createEntry(funcName);
-    match(SEMI);
-
-  } else if (curr_tok == COMMA) {
-
-    createEntry(funcName);
-    // must be decl
-
+  createEntry(varName);
+  if (curr_tok == COMMA) {
     id_list_rest();
-    match(SEMI);
+  }
+  match(SEMI);
+}
 
-  } else {
-    // must be func, match the rest
+/*
+ * func Quad:
+ * type = FUNC
+ * tableentry = `function's table entry
+ * child0 = expr_lit of formals
+ * child1 = body Quad
+ */
+void func_def() {
+  Quad *subtreeHd = NULL;
+  Quad **subtree = &subtreeHd;
 
-    Quad *newSubtree = new_quad(EXPR_LIST);
-    *subtree = newSubtree;
+  char *funcName = lexeme;
+  match(ID);
 
-    match(LPAREN);
-    curscope = LOCAL;
+  Quad *newSubtree = new_quad(EXPR_LIST);
+  *subtree = newSubtree;
 
-    int argcnt = formals(&newSubtree->child0);
+  match(LPAREN);
+  symtab_push(&symtab);
+  curscope = LOCAL;
 
-    curscope = GLOBAL;
-    // printf("creating new func %s with %d args\n", funcName, argcnt);
-    newSubtree->tableentry = createFuncEntry(funcName, argcnt);
-    curscope = LOCAL;
+  int argcnt = formals(&newSubtree->child0);
 
-    match(RPAREN);
-    match(LBRACE);
-    newSubtree->type = FUNC_DEF;
+  curscope = GLOBAL;
+  // printf("creating new func %s with %d args\n", funcName, argcnt);
+  newSubtree->tableentry = createFuncEntry(funcName, argcnt);
+  curscope = LOCAL;
 
-    opt_var_decls();
-    opt_stmt_list(&newSubtree->child1);
-    match(RBRACE);
+  match(RPAREN);
+  match(LBRACE);
+  in_body = 1;
+  newSubtree->type = FUNC_DEF;
+
+  opt_var_decls();
+  opt_stmt_list(&newSubtree->child1);
+  match(RBRACE);
+  in_body = 0;
+
+  void *tree = *subtree;
+  if (compact_ast_flag) {
+    if (!keep_ast_flag) {
+      compact_reset(&compact_tree);
+    }
+    tree = compact_handle(compact_add(&compact_tree, *subtree));
+  }
 
-    if (print_ast_flag)
-      print_ast(*subtree);
+  // the trees of a program with errors are not worth printing
+  if (print_ast_flag && ndiags == 0)
+    print_ast(tree);
 
-    freeQuad(*subtree);
-    freeSymTab(local);
-    local = NULL;
-    curscope = GLOBAL;
+  if (keep_ast_flag) {
+    keep_tree(tree);
+  }
+  if (!keep_ast_flag || compact_ast_flag) {
+    arena_reset(&quad_arena);
   }
+  symtab_pop(&symtab);
+  curscope = GLOBAL;
 }
 
 int opt_formals(Quad **subtree) {
@@ -283,77 +470,139 @@ void opt_var_decls() {
   }
 }
 
+/*
+ * opt_stmt_list() - parses the statements of a function body.  Blocks and
+ *                   the bodies of if, else and while nest through stmtstack
+ *                   rather than the C stack: opening one pushes a frame, and
+ *                   each finished statement is handed to the frame on top,
+ *                   closing every frame it completes.
+ */
 void opt_stmt_list(Quad **subtree) {
   assert(*subtree == NULL);
 
-  Quad *newSubtree = NULL;
-  Quad *curSubtree = NULL;
+  if (!starts_stmt(curr_tok)) {
+    return;
+  }
+
+  jmp_buf env;
+  jmp_buf *outer = recover_at;
+  int bottom = nstmts;
+  push_stmt(IN_LIST, NULL);
 
-  if (curr_tok == ID || curr_tok == kwWHILE || curr_tok == kwIF ||
-      curr_tok == kwRETURN || curr_tok == LBRACE || curr_tok == SEMI) {
-    newSubtree = new_quad(STMT_LIST);
-    *subtree = newSubtree;
-    curSubtree = newSubtree;
+  if (setjmp(env)) {
+    // drop the statement in error; at EOF there is nothing to resume
+    if (!sync_stmt()) {
+      recover_at = outer;
+      longjmp(*outer, 1);
+    }
+    if (finish_stmt(NULL, subtree, bottom)) {
+      recover_at = outer;
+      return;
+    }
   }
+  recover_at = &env;
+
+  for (;;) {
+    // open statements until one is finished
+    Quad *tree = NULL;
+    stmt_mark = nscratch;
+    switch (curr_tok) {
+    case (LBRACE):
+      match(LBRACE);
+      if (starts_stmt(curr_tok)) {
+        push_stmt(IN_LIST, NULL);
+        continue;
+      }
+      match(RBRACE);
+      break;
+    case (kwIF):
+      tree = new_quad(IF);
+      match(kwIF);
+      match(LPAREN);
+      bool_exp(&tree->child0);
+      match(RPAREN);
+      push_stmt(IN_IF, tree);
+      continue;
+    case (kwWHILE):
+      tree = new_quad(WHILE);
+      match(kwWHILE);
+      match(LPAREN);
+      bool_exp(&tree->child0);
+      match(RPAREN);
+      push_stmt(IN_WHILE, tree);
+      continue;
+    default:
+      simple_stmt(&tree);
+      break;
+    }
 
-  // iterate while the curr_tok is in the first set of stmt
-  while (curr_tok == ID || curr_tok == kwWHILE || curr_tok == kwIF ||
-         curr_tok == kwRETURN || curr_tok == LBRACE || curr_tok == SEMI) {
-    stmt(&curSubtree->child0);
+    if (finish_stmt(tree, subtree, bottom)) {
+      recover_at = outer;
+      return;
+    }
+  }
+}
 
-    if (curSubtree->child0) {
-      curSubtree->child1 = new_quad(STMT_LIST);
-      curSubtree = curSubtree->child1;
+/*
+ * finish_stmt() - hands a finished statement to the frames it finishes, until
+ *                 one wants another statement; returns 1 once the frame at
+ *                 bottom, the whole list, is finished and stored in *subtree
+ */
+int finish_stmt(Quad *tree, Quad **subtree, int bottom) {
+  for (;;) {
+    StmtFrame *top = &stmtstack[nstmts - 1];
+
+    if (top->kind == IN_IF) {
+      top->node->child1 = tree;
+      if (curr_tok == kwELSE) {
+        match(kwELSE);
+        top->kind = IN_ELSE;
+        return 0;
+      }
+    } else if (top->kind == IN_ELSE) {
+      top->node->child2 = tree;
+    } else if (top->kind == IN_WHILE) {
+      top->node->child1 = tree;
+    } else {
+      if (tree) {
+        list_add(tree);
+      }
+      if (starts_stmt(curr_tok)) {
+        return 0;
+      }
+      tree = list_end(STMT_LIST, top->base);
+      if (--nstmts == bottom) {
+        *subtree = tree;
+        return 1;
+      }
+      stmt_mark = nscratch;
+      match(RBRACE);
+      continue;
     }
+    tree = top->node;
+    nstmts--;
   }
 }
 
-void stmt(Quad **subtree) {
+/*
+ * simple_stmt() - parses a statement with no statement inside it
+ */
+void simple_stmt(Quad **subtree) {
   assert(*subtree == NULL);
 
-  char id[1024];
   switch (curr_tok) {
   case (ID):
-    if (curr_tok == ID && strlen(lexeme)) {
-      strcpy(id, lexeme);
-    }
-    match(ID);
-    // Could be either assignment or fn call; leftfactor
-    if (curr_tok == opASSG) {
-      Quad *newSubtree = new_quad(ASSG);
-      *subtree = newSubtree;
-      // printf("In op assign\n");
-      match(opASSG);
-      check_var(id);
-
-      newSubtree->tableentry = getentry(id, EITHER);
-      newSubtree->child0 = new_quad(IDENTIFIER);
-      newSubtree->child0->tableentry = newSubtree->tableentry;
-
-      arith_exp(&newSubtree->child1);
-      match(SEMI);
-      return;
+    // Could be either assignment or fn call; ID = starts an assignment
+    if (peek(1) == opASSG) {
+      assg_stmt(subtree);
+      break;
     }
-    // match the rest of fn call
-
-    fn_call(subtree, id);
-
+    fn_call(subtree);
     match(SEMI);
     break;
-  case (kwWHILE):
-    while_stmt(subtree);
-    break;
-  case (kwIF):
-    if_stmt(subtree);
-    break;
   case (kwRETURN):
     return_stmt(subtree);
     break;
-  case (LBRACE):
-    match(LBRACE);
-    opt_stmt_list(subtree);
-    match(RBRACE);
-    break;
   case (SEMI):
     match(SEMI);
     break;
@@ -363,42 +612,6 @@ void stmt(Quad **subtree) {
   }
 }
 
-void if_stmt(Quad **subtree) {
-  assert(*subtree == NULL);
-
-  Quad *newSubtree = new_quad(IF);
-  *subtree = newSubtree;
-
-  match(kwIF);
-  match(LPAREN);
-
-  bool_exp(&newSubtree->child0);
-  match(RPAREN);
-
-  stmt(&newSubtree->child1);
-
-  if (curr_tok == kwELSE) {
-    match(kwELSE);
-    stmt(&newSubtree->child2);
-  }
-}
-
-void while_stmt(Quad **subtree) {
-  assert(*subtree == NULL);
-
-  Quad *newSubtree = new_quad(WHILE);
-  *subtree = newSubtree;
-
-  match(kwWHILE);
-  match(LPAREN);
-
-  bool_exp(&newSubtree->child0);
-
-  match(RPAREN);
-
-  stmt(&newSubtree->child1);
-}
-
 void return_stmt(Quad **subtree) {
   assert(*subtree == NULL);
 
@@ -419,28 +632,47 @@ void return_stmt(Quad **subtree) {
 void assg_stmt(Quad **subtree) {
   assert(*subtree == NULL);
 
-  Quad *newSubtree = new_quad(EXPR_LIST);
+  Quad *newSubtree = new_quad(ASSG);
   *subtree = newSubtree;
 
-  newSubtree->type = ASSG;
-  if (curr_tok == ID) {
-    newSubtree->tableentry = getentry(lexeme, curscope);
-  }
+  char *id = lexeme;
   match(ID);
   match(opASSG);
+  check_var(id);
+
+  newSubtree->tableentry = getentry(id, EITHER);
+  newSubtree->child0 = new_quad(IDENTIFIER);
+  newSubtree->child0->tableentry = newSubtree->tableentry;
+
   arith_exp(&newSubtree->child1);
   match(SEMI);
 }
 
-void fn_call(Quad **subtree, char *id) {
+void fn_call(Quad **subtree) {
   assert(*subtree == NULL);
 
   Quad *newSubtree = new_quad(FUNC_CALL);
   *subtree = newSubtree;
 
+  char *id = lexeme;
+  int id_tok = tok_idx;
+  match(ID);
   newSubtree->tableentry = getentry(id, GLOBAL);
 
   match(LPAREN);
+  if (defer_calls_flag && chk_decl_flag && !getentry(id, EITHER)) {
+    // the callee may be defined further on; its arity is checked at the end
+    int call = npend_calls;
+    newSubtree->tableentry = defer_call(id, id_tok);
+    pend_calls[call].argcnt = opt_expr_list(&newSubtree->child0, -1);
+    match(RPAREN);
+    return;
+  }
+  if (newSubtree->tableentry == NULL) {
+    // without --chk_decl the callee need not be declared, but the call node
+    // still needs an entry to name it by
+    newSubtree->tableentry = pend_stub(id);
+  }
   int expected_argcnt = check_arg_count(id);
   int exprcnt = opt_expr_list(&newSubtree->child0, expected_argcnt);
   match(RPAREN);
@@ -465,6 +697,11 @@ void fn_call(Quad **subtree, char *id) {
   }
 }
 
+/*
+ * opt_expr_list() - parses the arguments of a call, checking their number
+ *                   against expected_argcnt, or not at all if it is -1;
+ *                   returns the number
+ */
 int opt_expr_list(Quad **subtree, int expected_argcnt) {
   if (curr_tok == ID || curr_tok == INTCON) {
     return expr_list(subtree, expected_argcnt);
@@ -484,20 +721,17 @@ int expr_list(Quad **subtree, int expected_argcnt) {
   assert(*subtree == NULL);
 
   Quad *newSubtree = NULL;
-  Quad *curSubtree = NULL;
-
-  newSubtree = new_quad(EXPR_LIST);
-  *subtree = newSubtree;
-  curSubtree = newSubtree;
+  int base = nscratch;
 
-  print_ast(newSubtree);
   int exprcnt = 0;
 
-  arith_exp(&curSubtree->child0);
+  arith_exp(&newSubtree);
+  list_add(newSubtree);
 
   exprcnt++;
 
-  if (chk_decl_flag && exprcnt > expected_argcnt) {
+  if (chk_decl_flag && expected_argcnt >= 0 &&
+      exprcnt > expected_argcnt) {
     char msg[1024];
     sprintf(msg,
             "wrong number of args for function call, expected %d, got %d\n",
@@ -509,12 +743,12 @@ int expr_list(Quad **subtree, int expected_argcnt) {
     match(COMMA);
     exprcnt++;
 
-    curSubtree->child1 = new_quad(EXPR_LIST);
-    curSubtree = curSubtree->child1;
+    newSubtree = NULL;
+    arith_exp(&newSubtree);
+    list_add(newSubtree);
 
-    arith_exp(&curSubtree->child0);
-
-    if (chk_decl_flag && exprcnt > expected_argcnt) {
+    if (chk_decl_flag && expected_argcnt >= 0 &&
+        exprcnt > expected_argcnt) {
       char msg[1024];
       sprintf(msg,
               "wrong number of args for function call, expected %d, got %d\n",
@@ -523,25 +757,95 @@ int expr_list(Quad **subtree, int expected_argcnt) {
     }
   }
 
+  *subtree = list_end(EXPR_LIST, base);
   return exprcnt;
 }
 
 void bool_exp(Quad **subtree) {
   assert(*subtree == NULL);
 
-  Quad *newSubtree = new_quad(DUMMY);
-  *subtree = newSubtree;
-
-  arith_exp(&newSubtree->child0);
-  newSubtree->type = relop();
-  arith_exp(&newSubtree->child1);
+  *subtree = expression(1);
+  if (!is_bool(*subtree)) {
+    linepexit(curr_tok, lexeme, "undefined operator.");
+  }
 }
 
 void arith_exp(Quad **subtree) {
   assert(*subtree == NULL);
 
-  Quad *newSubtree = new_quad(DUMMY);
-  *subtree = newSubtree;
+  *subtree = expression(0);
+}
+
+/*
+ * expression() - parses an expression by precedence climbing: operands go on
+ *                the scratch stack and operators wait on opstack until one
+ *                of lower precedence arrives, so no operator chain recurses.
+ *                Relational and logical operators are only taken when
+ *                boolean is set; otherwise they end the expression for the
+ *                caller to reject.
+ */
+Quad *expression(int boolean) {
+  int opbase = nops;
+  int open = 0;
+
+  for (;;) {
+    // prefix minus signs and open parentheses, then an operand
+    if (curr_tok == opSUB) {
+      push_op(UMINUS);
+      match(opSUB);
+      continue;
+    }
+    if (curr_tok == LPAREN) {
+      push_op(DUMMY);
+      open++;
+      match(LPAREN);
+      continue;
+    }
+    list_add(operand());
+
+    // close parentheses, until a binary operator or the end
+    NodeType op = binop(curr_tok, boolean);
+    while (op == DUMMY && curr_tok == RPAREN && open > 0) {
+      while (opstack[nops - 1] != DUMMY) {
+        reduce();
+      }
+      nops--;
+      open--;
+      match(RPAREN);
+      op = binop(curr_tok, boolean);
+    }
+    if (op == DUMMY) {
+      break;
+    }
+
+    while (nops > opbase && prec(opstack[nops - 1]) >= prec(op)) {
+      reduce();
+    }
+    push_op(op);
+    match(curr_tok);
+  }
+
+  if (open > 0) {
+    match(RPAREN);
+  }
+  while (nops > opbase) {
+    reduce();
+  }
+  return scratch[--nscratch];
+}
+
+/*
+ * operand() - parses an ID, a function call or an INTCON
+ */
+Quad *operand() {
+  Quad *newSubtree = NULL;
+
+  if (curr_tok == ID && peek(1) == LPAREN) {
+    fn_call(&newSubtree);
+    return newSubtree;
+  }
+
+  newSubtree = new_quad(DUMMY);
 
   if (curr_tok == ID) {
     symboltab *tableentry;
@@ -561,63 +865,164 @@ void arith_exp(Quad **subtree) {
     match(ID);
     newSubtree->type = IDENTIFIER;
     newSubtree->tableentry = tableentry;
-    return;
+    return newSubtree;
+  }
+
+  if (curr_tok == INTCON && lval < 0) {
+    char msg[1024];
+    sprintf(msg, "integer constant out of range at column %d, maximum is %d",
+            src_col(scanner, toks.off[tok_idx]), INT_MAX);
+    linepexit(curr_tok, NULL, msg);
   }
 
   newSubtree->type = INTCONST;
   newSubtree->immediate = lval;
   match(INTCON);
+  return newSubtree;
 }
 
-NodeType relop() {
-  switch (curr_tok) {
+/*
+ * binop() - the node type of a binary operator token, or DUMMY if t is not
+ *           one; relational and logical operators count only if boolean
+ */
+NodeType binop(Token t, int boolean) {
+  switch (t) {
+  case (opADD):
+    return ADD;
+  case (opSUB):
+    return SUB;
+  case (opMUL):
+    return MUL;
+  case (opDIV):
+    return DIV;
+  default:
+    break;
+  }
+  if (!boolean) {
+    return DUMMY;
+  }
+
+  switch (t) {
   case (opEQ):
-    match(opEQ);
     return EQ;
   case (opNE):
-    match(opNE);
     return NE;
   case (opLE):
-    match(opLE);
     return LE;
   case (opLT):
-    match(opLT);
     return LT;
   case (opGE):
-    match(opGE);
     return GE;
   case (opGT):
-    match(opGT);
     return GT;
+  case (opAND):
+    return AND;
+  case (opOR):
+    return OR;
   default:
-    linepexit(curr_tok, lexeme, "undefined operator.");
-    return -1;
+    return DUMMY;
   }
 }
 
+/*
+ * prec() - how tightly an operator binds; an open parenthesis (DUMMY) binds
+ *          least, so nothing is reduced past it
+ */
+int prec(NodeType op) {
+  switch (op) {
+  case OR:
+    return 1;
+  case AND:
+    return 2;
+  case EQ:
+  case NE:
+  case LE:
+  case LT:
+  case GE:
+  case GT:
+    return 3;
+  case ADD:
+  case SUB:
+    return 4;
+  case MUL:
+  case DIV:
+    return 5;
+  case UMINUS:
+    return 6;
+  default:
+    return 0;
+  }
+}
+
+/*
+ * is_bool() - whether a tree is a comparison or a logical expression
+ */
+int is_bool(Quad *tree) {
+  return (tree->type >= EQ && tree->type <= GT) || tree->type == AND ||
+         tree->type == OR;
+}
+
+void push_op(NodeType op) {
+  if (nops == capops) {
+    capops = capops ? capops * 2 : 64;
+    opstack = realloc(opstack, sizeof(NodeType) * capops);
+  }
+  opstack[nops++] = op;
+}
+
+/*
+ * reduce() - applies the operator on top of opstack to the operands on top
+ *            of the scratch stack, checking they are of the right kind
+ */
+void reduce() {
+  NodeType op = opstack[--nops];
+  Quad *newSubtree = new_quad(op);
+
+  if (op == UMINUS) {
+    newSubtree->child0 = scratch[--nscratch];
+  } else {
+    newSubtree->child1 = scratch[--nscratch];
+    newSubtree->child0 = scratch[--nscratch];
+  }
+
+  int logical = op == AND || op == OR;
+  if (is_bool(newSubtree->child0) != logical ||
+      (newSubtree->child1 && is_bool(newSubtree->child1) != logical)) {
+    linepexit(curr_tok, lexeme,
+              logical ? "operand of a logical operator is not a condition."
+                      : "condition used as an arithmetic operand.");
+  }
+  list_add(newSubtree);
+}
+
+void push_stmt(pending kind, Quad *node) {
+  if (nstmts == capstmts) {
+    capstmts = capstmts ? capstmts * 2 : 64;
+    stmtstack = realloc(stmtstack, sizeof(StmtFrame) * capstmts);
+  }
+  stmtstack[nstmts].kind = kind;
+  stmtstack[nstmts].node = node;
+  stmtstack[nstmts].base = nscratch;
+  nstmts++;
+}
+
 void type() {
   match(kwINT);
   //
 }
 
 symboltab *getentry(char *id, scopetype scope) {
-  for (int i = 0; i < 2; i++) {
-    symboltab *iscope = local;
-
-    if (i > 0 || scope == GLOBAL)
-      iscope = globl;
-
-    for (symboltab *jtab = iscope; jtab != NULL; jtab = jtab->next) {
-      if (!strcmp(id, jtab->name)) {
-        return jtab;
-      }
-    }
-
-    if (scope != EITHER) {
-      break;
-    }
+  // names are interned by the scanner, so equal names are the same pointer
+  if (scope == EITHER) {
+    return symtab_lookup(&symtab, id);
   }
-  return NULL;
+  if (scope == GLOBAL) {
+    return symtab_lookup_at(&symtab, id, 0);
+  }
+  if (symtab.depth == 0) {
+    return NULL;
+  }
+  return symtab_lookup_at(&symtab, id, symtab.depth);
 }
 
 void check_var(char *id) {
@@ -635,6 +1040,10 @@ void check_var(char *id) {
   }
 }
 
+/*
+ * check_arg_count() - the number of arguments id takes, or -1 if it is not
+ *                     declared yet, which only --chk_decl reports as an error
+ */
 int check_arg_count(char *id) {
   symboltab *tableentry = getentry(id, EITHER);
   if (chk_decl_flag) {
@@ -648,17 +1057,199 @@ int check_arg_count(char *id) {
                 "symbol declared as a variable but used as a function.");
     }
   }
+  if (!tableentry) {
+    return -1;
+  }
   return tableentry->argcnt;
 }
 
+/*
+ * pend_home() - the slot of pend_slots a name hashes to; Fibonacci hashing of
+ *               the pointer, as in the symbol table
+ */
+int pend_home(char *name) {
+  return ((uintptr_t)name * 0x9E3779B97F4A7C15ull) >> pend_shift;
+}
+
+/*
+ * pend_find() - the slot of pend_slots holding name's stand-in, or the empty
+ *               slot where it would go
+ */
+int pend_find(char *name) {
+  int mask = npend_slots - 1;
+  int i = pend_home(name);
+
+  while (pend_slots[i] != NULL && pend_slots[i]->name != name) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+/*
+ * pend_grow() - doubles pend_slots, or makes it, and rehashes the stand-ins
+ */
+void pend_grow() {
+  symboltab **old = pend_slots;
+  int nold = npend_slots;
+
+  npend_slots = nold ? nold * 2 : 64;
+  pend_shift = 64 - __builtin_ctz(npend_slots);
+  pend_slots = calloc(npend_slots, sizeof(symboltab *));
+  for (int i = 0; i < nold; i++) {
+    if (old[i] != NULL) {
+      pend_slots[pend_find(old[i]->name)] = old[i];
+    }
+  }
+  free(old);
+}
+
+/*
+ * pend_stub() - the stand-in entry for id, a name not declared yet, made the
+ *               first time it is asked for
+ */
+symboltab *pend_stub(char *id) {
+  if (2 * (npend_names + 1) > npend_slots) {
+    pend_grow();
+  }
+  int slot = pend_find(id);
+  if (pend_slots[slot] == NULL) {
+    symboltab *stub = calloc(1, sizeof(symboltab));
+    stub->name = id;
+    stub->type = ID;
+    stub->dtype = FUNC;
+    stub->argcnt = -1;
+    pend_slots[slot] = stub;
+    npend_names++;
+  }
+  return pend_slots[slot];
+}
+
+/*
+ * defer_call() - records a call to id, a name not declared yet, whose name is
+ *                token tok; returns the stand-in entry for the call node.
+ *                The call's argcnt is left for the caller to fill in.
+ */
+symboltab *defer_call(char *id, int tok) {
+  symboltab *stub = pend_stub(id);
+
+  if (npend_calls == cappend_calls) {
+    cappend_calls = cappend_calls ? cappend_calls * 2 : 64;
+    pend_calls = realloc(pend_calls, sizeof(PendCall) * cappend_calls);
+  }
+  pend_calls[npend_calls].tok = tok;
+  pend_calls[npend_calls].argcnt = 0;
+  pend_calls[npend_calls].callee = stub;
+  pend_calls[npend_calls].decl = NULL;
+  npend_calls++;
+  return stub;
+}
+
+/*
+ * resolve_calls() - checks the deferred calls against the global declarations
+ *                   made by the end of the input.  Each call keeps its
+ *                   callee's declaration in decl, and the stand-in takes on
+ *                   the declaration's kind and arity; errors are reported at
+ *                   the callee's name, in source order.
+ */
+void resolve_calls() {
+  jmp_buf env;
+  volatile int i = 0;
+
+  for (int c = 0; c < npend_calls; c++) {
+    PendCall *call = &pend_calls[c];
+    call->decl = symtab_lookup_at(&symtab, call->callee->name, 0);
+    if (call->decl != NULL) {
+      call->callee->dtype = call->decl->dtype;
+      call->callee->argcnt = call->decl->argcnt;
+    }
+  }
+
+  // with --max_errors, each error resumes at the next call
+  if (setjmp(env)) {
+    i++;
+  }
+  recover_at = &env;
+  for (; i < npend_calls; i++) {
+    PendCall *call = &pend_calls[i];
+    symboltab *decl = call->decl;
+    if (decl != NULL && decl->dtype == FUNC && decl->argcnt == call->argcnt) {
+      continue;
+    }
+
+    tok_idx = call->tok - 1;
+    advance();
+    if (decl == NULL) {
+      linepexit(curr_tok, lexeme, "symbol undefined.");
+    }
+    if (decl->dtype != FUNC) {
+      linepexit(curr_tok, lexeme,
+                "symbol declared as a variable but used as a function.");
+    }
+    char msg[1024];
+    sprintf(msg,
+            "wrong number of args for function call, expected %d, got %d\n",
+            decl->argcnt, call->argcnt);
+    linepexit(curr_tok, lexeme, msg);
+  }
+  recover_at = NULL;
+}
+
+/*
+ * format_error() - the message of a printf format, in malloced storage
+ */
+char *format_error(const char *fmt, ...) {
+  va_list ap;
+
+  va_start(ap, fmt);
+  int len = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+
+  char *text = malloc(len + 1);
+  va_start(ap, fmt);
+  vsnprintf(text, len + 1, fmt, ap);
+  va_end(ap);
+  return text;
+}
+
 void linepexit(Token t, char *lexeme, char *msg) {
-  fprintf(stderr, "ERROR LINE %d at token %s, at lexeme %s, %s\n", linecnt,
-          token_name[t], lexeme, msg);
-  exit(1);
+  int line = src_line(scanner, toks.off[tok_idx]);
+  char *text;
+
+  if (t == EOF) {
+    text = format_error("ERROR LINE %d at token EOF, at end of input, %s\n",
+                        line, msg);
+  } else if (lexeme == NULL) {
+    text = format_error("ERROR LINE %d at token %s, at lexeme %.*s, %s\n",
+                        line, token_name[t], (int)toks.len[tok_idx],
+                        scan_text(scanner) + toks.off[tok_idx], msg);
+  } else {
+    text = format_error("ERROR LINE %d at token %s, at lexeme %s, %s\n", line,
+                        token_name[t], lexeme, msg);
+  }
+
+  if (max_errors <= 1) {
+    fputs(text, stderr);
+    free(text);
+    exit(1);
+  }
+
+  if (ndiags == capdiags) {
+    capdiags = capdiags ? capdiags * 2 : 64;
+    diags = realloc(diags, sizeof(Diag) * capdiags);
+  }
+  diags[ndiags].off = toks.off[tok_idx];
+  diags[ndiags].seq = ndiags;
+  diags[ndiags].text = text;
+  ndiags++;
+  if (ndiags >= max_errors || recover_at == NULL) {
+    report_errors();
+    exit(1);
+  }
+  longjmp(*recover_at, 1);
 }
 
 Quad *new_quad(NodeType t) {
-  Quad *new_quad = malloc(sizeof(Quad));
+  Quad *new_quad = arena_alloc(&quad_arena, sizeof(Quad));
 
   // Fill in Quad with empty value to prevent memory errors
   new_quad->type = t;
@@ -671,29 +1262,206 @@ Quad *new_quad(NodeType t) {
   return new_quad;
 }
 
-void freeQuad(Quad *quad) {
-  if (quad->child0)
-    freeQuad(quad->child0);
-  if (quad->child1)
-    freeQuad(quad->child1);
-  if (quad->child2)
-    freeQuad(quad->child2);
-  free(quad);
+/*
+ * list_add() - adds an element to the list being built
+ */
+void list_add(void *elem) {
+  if (nscratch == capscratch) {
+    capscratch = capscratch ? capscratch * 2 : 256;
+    scratch = realloc(scratch, sizeof(void *) * capscratch);
+  }
+  scratch[nscratch++] = elem;
+}
+
+/*
+ * list_end() - makes a list node of the elements added since the scratch
+ *              stack held base of them, and pops those elements
+ */
+Quad *list_end(NodeType type, int base) {
+  int count = nscratch - base;
+  Quad *list = new_quad(type);
+
+  list->immediate = count;
+  list->elems = arena_alloc(&quad_arena, sizeof(Quad *) * (count + 1));
+  if (count > 0) {
+    // scratch is still NULL until the first element is added
+    memcpy(list->elems, scratch + base, sizeof(Quad *) * count);
+  }
+  list->elems[count] = NULL;
+  nscratch = base;
+  return list;
+}
+
+/*
+ * keep_tree() - saves a function's tree for ast_root; the kept trees wait at
+ *               the bottom of the scratch stack, under any list being built
+ */
+void keep_tree(void *tree) {
+  list_add(tree);
+}
+
+/*
+ * make_ast_root() - makes ast_root from the kept trees, in their own form
+ */
+void make_ast_root() {
+  if (!compact_ast_flag) {
+    ast_root = list_end(STMT_LIST, 0);
+    return;
+  }
+
+  uint32_t *items = malloc(sizeof(uint32_t) * (nscratch + 1));
+  for (int i = 0; i < nscratch; i++) {
+    items[i] = compact_index(scratch[i]);
+  }
+  ast_root = compact_handle(
+      compact_list(&compact_tree, STMT_LIST, items, nscratch));
+  nscratch = 0;
+  free(items);
+}
+
+/*
+ * ll1_check() - checks the syntax of the token stream with the table-driven
+ *               parser, reporting the first token it cannot take the way
+ *               match() and the statement parser do
+ */
+void ll1_check() {
+  int expected;
+  int bad = ll1_parse(&toks, &expected);
+
+  if (bad < 0) {
+    return;
+  }
+  tok_idx = bad - 1;
+  advance();
+
+  char msg[1024];
+  if (ll1_name(expected) != NULL) {
+    sprintf(msg, "syntax error in %s.", ll1_name(expected));
+  } else if (expected == TOK_EOF) {
+    sprintf(msg, "expected EOF");
+  } else {
+    sprintf(msg, "match error, expected %s", token_name[expected]);
+  }
+  linepexit(curr_tok, lexeme, msg);
+}
+
+/*
+ * sync_top() - recovers from an error outside a function's statements:
+ *              abandons the declaration or function being parsed and skips
+ *              to the next int outside any function body
+ */
+void sync_top() {
+  nops = 0;
+  nstmts = 0;
+  nscratch = top_mark;
+  while (symtab.depth > 0) {
+    symtab_pop(&symtab);
+  }
+  curscope = GLOBAL;
+  if (!keep_ast_flag || compact_ast_flag) {
+    arena_reset(&quad_arena);
+  }
+
+  int depth = in_body;
+  in_body = 0;
+  while (curr_tok != EOF && !(curr_tok == kwINT && depth <= 0)) {
+    if (curr_tok == LBRACE) {
+      depth++;
+    } else if (curr_tok == RBRACE) {
+      depth--;
+    }
+    advance();
+  }
+}
+
+/*
+ * sync_stmt() - recovers from an error in a statement: drops what was parsed
+ *               of it and skips to its end, past a semicolon or a block's
+ *               close brace, along with any else that follows; a close brace
+ *               of an enclosing block is left for that block.  Returns 0 if
+ *               the input ends first.
+ */
+int sync_stmt() {
+  int depth = 0;
+
+  nops = 0;
+  nscratch = stmt_mark;
+  for (;;) {
+    if (curr_tok == EOF) {
+      return 0;
+    }
+    if (curr_tok == RBRACE && depth == 0) {
+      return 1;
+    }
+
+    int ends = (curr_tok == SEMI && depth == 0) ||
+               (curr_tok == RBRACE && depth == 1);
+    if (curr_tok == LBRACE) {
+      depth++;
+    } else if (curr_tok == RBRACE) {
+      depth--;
+    }
+    advance();
+    if (ends && curr_tok != kwELSE) {
+      return 1;
+    }
+  }
 }
 
-void freeSymTab(symboltab *tabin) {
-  symboltab *nexttab = tabin;
-  while (tabin != NULL) {
-    nexttab = tabin->next;
-    free(tabin->name);
-    free(tabin);
-    tabin = nexttab;
+/*
+ * cmp_diags() - orders errors by position, then by when they were found
+ */
+int cmp_diags(const void *a, const void *b) {
+  const Diag *x = a, *y = b;
+
+  if (x->off != y->off) {
+    return x->off < y->off ? -1 : 1;
+  }
+  return x->seq - y->seq;
+}
+
+/*
+ * report_errors() - prints the recorded errors in source order
+ */
+void report_errors() {
+  qsort(diags, ndiags, sizeof(Diag), cmp_diags);
+  for (int i = 0; i < ndiags; i++) {
+    fputs(diags[i].text, stderr);
   }
 }
 
 void freeTabs(void) {
-  freeSymTab(local);
-  local = NULL;
-  freeSymTab(globl);
-  globl = NULL;
+  tokbuf_free(&toks);
+  arena_free(&quad_arena);
+  free(scratch);
+  scratch = NULL;
+  nscratch = capscratch = 0;
+  free(opstack);
+  opstack = NULL;
+  nops = capops = 0;
+  free(stmtstack);
+  stmtstack = NULL;
+  nstmts = capstmts = 0;
+  for (int i = 0; i < ndiags; i++) {
+    free(diags[i].text);
+  }
+  free(diags);
+  diags = NULL;
+  ndiags = capdiags = 0;
+  for (int i = 0; i < npend_slots; i++) {
+    free(pend_slots[i]);
+  }
+  free(pend_slots);
+  pend_slots = NULL;
+  npend_slots = npend_names = 0;
+  free(pend_calls);
+  pend_calls = NULL;
+  npend_calls = cappend_calls = 0;
+  if (compact_ast_flag) {
+    compact_free(&compact_tree);
+  }
+  ast_root = NULL;
+  symtab_free(&symtab);
+  scanner_destroy(scanner);
+  scanner = NULL;
 }
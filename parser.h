@@ -9,25 +9,29 @@
 #ifndef __PARSER_H__
 #define __PARSER_H__
 
-extern int get_token();
 extern int parse();
 
 extern int chk_decl_flag;
 extern int print_ast_flag;
+extern int keep_ast_flag;
+extern int compact_ast_flag;
+extern int ll1_flag;
+extern int max_errors;
+extern int defer_calls_flag;
 
 extern int curr_tok;
-extern int linecnt;
 extern char *lexeme;
 extern int lval;
 
 typedef enum { VAR, FUNC } DeclType;
 
 struct symboltab {
-  char *name;
+  char *name; /* interned by the scanner; compare by pointer */
   Token type;
   DeclType dtype;
   int argcnt;
-  struct symboltab *next;
+  int level;                /* scope depth it was declared at; 0 is global */
+  struct symboltab *shadow; /* entry for the same name in an outer scope */
 } typedef symboltab;
 
 #endif
@@ -0,0 +1,844 @@
+/*
+ * Author: Edward Fattell
+ * File: scanedit.c
+ * Purpose: Incremental re-lexing.  After an edit to the input, only the
+ *          tokens from the last one the edit cannot have changed up to the
+ *          point where the new tokens line up with the old ones again are
+ *          scanned; the rest are kept where they are.
+ *
+ *          Scanning from a token start depends only on the bytes from there
+ *          on and on whether a comment opener has a star-slash somewhere
+ *          after it.  So once a new token starts past the edit exactly where
+ *          an old one did, every later token is the old one moved by the
+ *          size change.  The one effect that reaches backwards is a new
+ *          star-slash closing a comment opener that used to be unclosed,
+ *          which is why re-lexing may start as far back as cmt_unclosed.
+ *
+ *          So that an edit costs time in the size of the edit rather than
+ *          the input, scan_edit_begin() splits the text into blocks of
+ *          about BLOCK bytes, each holding the tokens that start in it at
+ *          offsets from the block's start.  Fenwick trees over the blocks'
+ *          byte, token and newline counts find the block holding an offset,
+ *          token or line.  An edit rewrites only the blocks it touches, so
+ *          nothing past them is moved or renumbered.
+ */
+#include "scanner.h"
+#include "scansimd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define BLOCK 4096 /* bytes of text a block is made with */
+
+struct block {
+  char *text;
+  long len;
+  long cap;
+  long nls;      /* newlines in text */
+  TokenBuf toks; /* tokens starting in text, at offsets from its start */
+} typedef Block;
+
+struct editstate {
+  Block **blocks;
+  int nblocks;
+  int capblocks;
+  int ntoks;
+  long *fw_len;  /* Fenwick trees over blocks, 1-based: bytes, */
+  long *fw_toks; /* tokens */
+  long *fw_nls;  /* and newlines */
+  char *win;     /* the edited text being scanned again, and scratch space */
+  long capwin;
+  TokenBuf fresh; /* tokens scanned again */
+  TokenBuf span;  /* tokens of the blocks being rewritten */
+} typedef EditState;
+
+/*
+ * A token cursor walks the tokens in order; base is the offset of block b.
+ */
+struct tokcur {
+  int b;
+  int i;
+  long base;
+} typedef TokCur;
+
+/*******************************************************************************
+ *                                                                             *
+ *                                FENWICK TREES                                *
+ *                                                                             *
+ ******************************************************************************/
+
+/*
+ * fw_add() - adds d to the count of block i
+ */
+void fw_add(long *fw, int n, int i, long d) {
+  for (i++; i <= n; i += i & -i) {
+    fw[i] += d;
+  }
+}
+
+/*
+ * fw_sum() - the total count of blocks [0, i)
+ */
+long fw_sum(long *fw, int i) {
+  long sum = 0;
+
+  for (; i > 0; i -= i & -i) {
+    sum += fw[i];
+  }
+  return sum;
+}
+
+/*
+ * fw_find() - the number of leading blocks whose counts total at most x,
+ *             which is the index of the block holding the x'th unit
+ */
+int fw_find(long *fw, int n, long x) {
+  int pos = 0;
+  int step = 1;
+
+  while (step * 2 <= n) {
+    step *= 2;
+  }
+  for (; step > 0; step /= 2) {
+    if (pos + step <= n && fw[pos + step] <= x) {
+      pos += step;
+      x -= fw[pos];
+    }
+  }
+  return pos;
+}
+
+/*
+ * fw_build() - builds the three trees from the blocks in linear time
+ */
+void fw_build(EditState *ed) {
+  int n = ed->nblocks;
+
+  ed->fw_len = realloc(ed->fw_len, sizeof(long) * (ed->capblocks + 1));
+  ed->fw_toks = realloc(ed->fw_toks, sizeof(long) * (ed->capblocks + 1));
+  ed->fw_nls = realloc(ed->fw_nls, sizeof(long) * (ed->capblocks + 1));
+  for (int i = 1; i <= n; i++) {
+    ed->fw_len[i] = ed->blocks[i - 1]->len;
+    ed->fw_toks[i] = ed->blocks[i - 1]->toks.count;
+    ed->fw_nls[i] = ed->blocks[i - 1]->nls;
+  }
+  for (int i = 1; i <= n; i++) {
+    int up = i + (i & -i);
+    if (up <= n) {
+      ed->fw_len[up] += ed->fw_len[i];
+      ed->fw_toks[up] += ed->fw_toks[i];
+      ed->fw_nls[up] += ed->fw_nls[i];
+    }
+  }
+}
+
+/*******************************************************************************
+ *                                                                             *
+ *                                   BLOCKS                                    *
+ *                                                                             *
+ ******************************************************************************/
+
+/*
+ * block_at() - the block holding offset off; the end of the input is in the
+ *              last block
+ */
+int block_at(EditState *ed, long off) {
+  int b = fw_find(ed->fw_len, ed->nblocks, off);
+  return b < ed->nblocks ? b : ed->nblocks - 1;
+}
+
+/*
+ * block_of_tok() - the block holding token g
+ */
+int block_of_tok(EditState *ed, int g) {
+  return fw_find(ed->fw_toks, ed->nblocks, g);
+}
+
+/*
+ * block_fill() - sets a block's text to len bytes and its tokens to entries
+ *                [i0, i1) of src, whose offsets are base plus their offset
+ *                in the block
+ */
+void block_fill(Block *blk, const char *text, long len, TokenBuf *src, int i0,
+                int i1, long base) {
+  int n = i1 - i0;
+
+  blk->len = len;
+  blk->nls = 0;
+  blk->toks.count = n;
+  if (len > blk->cap) {
+    blk->cap = len;
+    blk->text = realloc(blk->text, blk->cap);
+  }
+  if (len > 0) {
+    memcpy(blk->text, text, len);
+    blk->nls = count_newlines(blk->text, 0, len);
+  }
+  if (n == 0) {
+    return;
+  }
+
+  if (n > blk->toks.cap) {
+    blk->toks.cap = n;
+    blk->toks.kind = realloc(blk->toks.kind, sizeof(uint8_t) * n);
+    blk->toks.off = realloc(blk->toks.off, sizeof(uint32_t) * n);
+    blk->toks.len = realloc(blk->toks.len, sizeof(uint32_t) * n);
+    blk->toks.val = realloc(blk->toks.val, sizeof(int32_t) * n);
+  }
+  memcpy(blk->toks.kind, src->kind + i0, sizeof(uint8_t) * n);
+  memcpy(blk->toks.len, src->len + i0, sizeof(uint32_t) * n);
+  memcpy(blk->toks.val, src->val + i0, sizeof(int32_t) * n);
+  for (int i = 0; i < n; i++) {
+    blk->toks.off[i] = src->off[i0 + i] - base;
+  }
+}
+
+void block_free(Block *blk) {
+  free(blk->text);
+  tokbuf_free(&blk->toks);
+  free(blk);
+}
+
+/*
+ * fill_blocks() - makes blocks [b, b + k) hold len bytes of text, starting at
+ *                 offset base, split evenly, and the tokens of src from i0 on
+ */
+void fill_blocks(EditState *ed, int b, int k, const char *text, long len,
+                 TokenBuf *src, int i0, long base) {
+  int i = i0;
+
+  for (int j = 0; j < k; j++) {
+    long from = len * j / k;
+    long to = len * (j + 1) / k;
+    int i1 = src->count;
+    if (j < k - 1) {
+      for (i1 = i; i1 < src->count && src->off[i1] < base + to; i1++) {
+      }
+    }
+    block_fill(ed->blocks[b + j], text + from, to - from, src, i, i1,
+               base + from);
+    i = i1;
+  }
+}
+
+/*
+ * text_copy() - copies the text in [from, to) to dst
+ */
+void text_copy(EditState *ed, long from, long to, char *dst) {
+  if (from >= to) {
+    return;
+  }
+  int b = block_at(ed, from);
+  long base = fw_sum(ed->fw_len, b);
+
+  while (from < to) {
+    Block *blk = ed->blocks[b++];
+    long end = base + blk->len < to ? base + blk->len : to;
+    memcpy(dst, blk->text + (from - base), end - from);
+    dst += end - from;
+    from = end;
+    base += blk->len;
+  }
+}
+
+/*
+ * text_byte() - the byte at off
+ */
+char text_byte(EditState *ed, long off) {
+  char ch;
+
+  text_copy(ed, off, off + 1, &ch);
+  return ch;
+}
+
+/*
+ * first_pair() - returns the offset of the first a, b byte pair that starts
+ *                in [from, to) of the text, or -1 if there is none
+ */
+long first_pair(EditState *ed, long len, long from, long to, char a, char b) {
+  if (to > len - 1) {
+    to = len - 1;
+  }
+  if (from >= to) {
+    return -1;
+  }
+  int bi = block_at(ed, from);
+  long base = fw_sum(ed->fw_len, bi);
+
+  for (; bi < ed->nblocks && base < to; base += ed->blocks[bi++]->len) {
+    Block *blk = ed->blocks[bi];
+    long pos = from > base ? from - base : 0;
+    for (; pos < blk->len && base + pos < to; pos++) {
+      if (blk->text[pos] != a) {
+        continue;
+      }
+      char next = pos + 1 < blk->len ? blk->text[pos + 1]
+                                     : text_byte(ed, base + pos + 1);
+      if (next == b) {
+        return base + pos;
+      }
+    }
+  }
+  return -1;
+}
+
+/*
+ * last_pair() - returns the offset of the last a, b byte pair that starts in
+ *               [from, to - 1) of the text, or -1 if there is none
+ */
+long last_pair(EditState *ed, long from, long to, char a, char b) {
+  if (to - 1 <= from) {
+    return -1;
+  }
+  int bi = block_at(ed, to - 2);
+  long base = fw_sum(ed->fw_len, bi);
+
+  for (;;) {
+    Block *blk = ed->blocks[bi];
+    long pos = to - 2 - base < blk->len - 1 ? to - 2 - base : blk->len - 1;
+    for (; pos >= 0 && base + pos >= from; pos--) {
+      if (blk->text[pos] != a) {
+        continue;
+      }
+      char next = pos + 1 < blk->len ? blk->text[pos + 1]
+                                     : text_byte(ed, base + pos + 1);
+      if (next == b) {
+        return base + pos;
+      }
+    }
+    if (bi == 0 || base <= from) {
+      return -1;
+    }
+    base -= ed->blocks[--bi]->len;
+  }
+}
+
+/*******************************************************************************
+ *                                                                             *
+ *                                   TOKENS                                    *
+ *                                                                             *
+ ******************************************************************************/
+
+void cur_seek(EditState *ed, int g, TokCur *c) {
+  c->b = block_of_tok(ed, g);
+  if (c->b >= ed->nblocks) {
+    c->b = ed->nblocks - 1;
+  }
+  c->i = g - fw_sum(ed->fw_toks, c->b);
+  c->base = fw_sum(ed->fw_len, c->b);
+}
+
+void cur_next(EditState *ed, TokCur *c) {
+  c->i++;
+  while (c->i >= ed->blocks[c->b]->toks.count && c->b + 1 < ed->nblocks) {
+    c->base += ed->blocks[c->b]->len;
+    c->b++;
+    c->i = 0;
+  }
+}
+
+#define cur_toks(ed, c) (&(ed)->blocks[(c)->b]->toks)
+#define cur_off(ed, c) ((c)->base + cur_toks(ed, c)->off[(c)->i])
+
+/*
+ * first_affected() - returns the index of the first token that has to be
+ *                    scanned again: the one after the last token that ends
+ *                    before pos.  The DFA decides where a token ends by
+ *                    reading the byte just past it, hence the strict test.
+ */
+int first_affected(EditState *ed, long pos) {
+  int lo = 0;
+  int hi = ed->ntoks;
+  TokCur c;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    cur_seek(ed, mid, &c);
+    if (cur_off(ed, &c) + cur_toks(ed, &c)->len[c.i] < pos) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/*******************************************************************************
+ *                                                                             *
+ *                                   EDITING                                   *
+ *                                                                             *
+ ******************************************************************************/
+
+/*
+ * An edit replaces oldlen bytes at start with newlen bytes of text.  Until it
+ * is applied to the blocks, the edited text is read through edited_copy().
+ */
+struct edit {
+  long start;
+  long oldlen;
+  const char *text;
+  long newlen;
+} typedef Edit;
+
+/*
+ * edited_copy() - copies [from, to) of the edited text to dst
+ */
+void edited_copy(EditState *ed, Edit *e, long from, long to, char *dst) {
+  long delta = e->newlen - e->oldlen;
+  long mid = e->start + e->newlen;
+
+  if (from < e->start) {
+    long end = to < e->start ? to : e->start;
+    text_copy(ed, from, end, dst);
+    dst += end - from;
+    from = end;
+  }
+  if (from < to && from < mid) {
+    long end = to < mid ? to : mid;
+    memcpy(dst, e->text + (from - e->start), end - from);
+    dst += end - from;
+    from = end;
+  }
+  if (from < to) {
+    text_copy(ed, from - delta, to - delta, dst);
+  }
+}
+
+/*
+ * win_reserve() - makes the window hold at least n bytes
+ */
+char *win_reserve(EditState *ed, long n) {
+  if (n > ed->capwin) {
+    ed->capwin = n > 2 * ed->capwin ? n : 2 * ed->capwin;
+    ed->win = realloc(ed->win, ed->capwin);
+  }
+  return ed->win;
+}
+
+/*
+ * last_cmt_close() - returns the offset of the last star-slash that starts in
+ *                    buf[from, to - 1), or -1 if there is none
+ */
+long last_cmt_close(const char *buf, long from, long to) {
+  for (long pos = to - 2; pos >= from; pos--) {
+    if (buf[pos] == '*' && buf[pos + 1] == '/') {
+      return pos;
+    }
+  }
+  return -1;
+}
+
+/*
+ * edit_last_close() - returns the last star-slash of the edited input given
+ *                     the last one before the edit, looking only near the
+ *                     edit unless the edit removed that star-slash
+ */
+long edit_last_close(Scanner *sc, Edit *e, long last) {
+  EditState *ed = sc->edits;
+  long len = sc->len + e->newlen - e->oldlen;
+
+  if (last >= e->start + e->oldlen) {
+    return last + e->newlen - e->oldlen;
+  }
+
+  // one may start just before or end just after the new text
+  long from = e->start > 0 ? e->start - 1 : 0;
+  long to = e->start + e->newlen + 1 < len ? e->start + e->newlen + 1 : len;
+  edited_copy(ed, e, from, to, win_reserve(ed, to - from));
+  long pos = last_cmt_close(ed->win, 0, to - from);
+  if (pos >= 0) {
+    return from + pos;
+  }
+  if (last + 1 < e->start) {
+    return last;
+  }
+  return last_pair(ed, 0, e->start, '*', '/');
+}
+
+/*
+ * edit_first_opener() - returns the offset of the first comment opener of
+ *                       the edited input that starts in [from, to), where
+ *                       to is at most the start of the edit, or -1
+ */
+long edit_first_opener(Scanner *sc, Edit *e, long from, long to) {
+  long len = sc->len + e->newlen - e->oldlen;
+  long pos = first_pair(sc->edits, sc->len, from,
+                        to < e->start - 1 ? to : e->start - 1, '/', '*');
+
+  // the last one may end in the new text
+  if (pos < 0 && to == e->start && from < to && len > e->start) {
+    char next;
+    edited_copy(sc->edits, e, e->start, e->start + 1, &next);
+    if (text_byte(sc->edits, e->start - 1) == '/' && next == '*') {
+      pos = e->start - 1;
+    }
+  }
+  return pos;
+}
+
+/*
+ * rescan() - scans the edited text from pos0, appending to ed->fresh the
+ *            tokens up to the first one that lines up with an old token, the
+ *            old token *old if there is one.  The text is scanned through a
+ *            window holding wlen bytes of it; returns 0 if a token or
+ *            comment ran off the end of the window, so it has to be larger.
+ */
+int rescan(Scanner *sc, Edit *e, long pos0, long wlen, int *old) {
+  EditState *ed = sc->edits;
+  long delta = e->newlen - e->oldlen;
+  long len = sc->len + delta;
+  int atend = pos0 + wlen == len;
+  long oldend = e->start + e->oldlen;
+  TokenBuf *fresh = &ed->fresh;
+  Scanner w;
+  TokCur c;
+
+  // old tokens wholly past the edit are candidates for resynchronizing
+  cur_seek(ed, *old, &c);
+  while (*old < ed->ntoks && cur_off(ed, &c) < oldend) {
+    (*old)++;
+    cur_next(ed, &c);
+  }
+
+  edited_copy(ed, e, pos0, pos0 + wlen, win_reserve(ed, wlen + 1));
+  memset(&w, 0, sizeof(w));
+  w.buf = ed->win;
+  w.len = wlen;
+  w.cmt_unclosed = sc->cmt_unclosed > pos0 ? sc->cmt_unclosed - pos0 : 0;
+  w.nl_count = -1;
+  w.ids = sc->ids;
+  long unclosed = w.cmt_unclosed;
+
+  int whole = 1;
+  fresh->count = 0;
+  for (;;) {
+    int off, tlen;
+    int toke = scan_token(&w, &off, &tlen);
+    int kind = toke == EOF ? TOK_EOF : toke;
+    long at = pos0 + off;
+
+    // every opener before cmt_unclosed has a close, if the window reaches it
+    if (w.cmt_unclosed != unclosed ||
+        (!atend && (toke == EOF || off + tlen >= wlen))) {
+      whole = 0;
+      break;
+    }
+
+    if (at >= e->start + e->newlen) {
+      while (*old < ed->ntoks && cur_off(ed, &c) + delta < at) {
+        (*old)++;
+        cur_next(ed, &c);
+      }
+      if (*old < ed->ntoks && cur_off(ed, &c) + delta == at &&
+          cur_toks(ed, &c)->kind[c.i] == kind &&
+          cur_toks(ed, &c)->len[c.i] == tlen) {
+        break;
+      }
+    }
+
+    tokbuf_reserve(fresh, 1);
+    int i = fresh->count++;
+    fresh->kind[i] = kind;
+    fresh->off[i] = at;
+    fresh->len[i] = tlen;
+    fresh->val[i] = toke == ID ? w.tok_id : w.lval;
+    if (toke == EOF) {
+      *old = ed->ntoks;
+      break;
+    }
+  }
+  sc->ids = w.ids;
+  return whole;
+}
+
+/*
+ * apply_edit() - replaces tokens [first, old) with ed->fresh and applies the
+ *                edit to the text, rewriting the blocks from the one holding
+ *                pos0 to the last one holding anything that changed.  The
+ *                blocks keep their number unless they get too full or too
+ *                empty, in which case the range is split anew.
+ */
+void apply_edit(Scanner *sc, Edit *e, long pos0, int first, int old) {
+  EditState *ed = sc->edits;
+  TokenBuf *fresh = &ed->fresh;
+  TokenBuf *span = &ed->span;
+  long delta = e->newlen - e->oldlen;
+  long oldend = e->start + e->oldlen;
+
+  int b0 = block_at(ed, pos0);
+  int b1 = block_at(ed, e->oldlen > 0 ? oldend - 1 : e->start);
+  if (old > first && block_of_tok(ed, old - 1) > b1) {
+    b1 = block_of_tok(ed, old - 1);
+  }
+  if (fresh->count > 0) {
+    long last = fresh->off[fresh->count - 1];
+    last = last >= e->start + e->newlen ? last - delta : e->start;
+    if (block_at(ed, last) > b1) {
+      b1 = block_at(ed, last);
+    }
+  }
+  if (old == ed->ntoks) {
+    b1 = ed->nblocks - 1;
+  }
+
+  long from = fw_sum(ed->fw_len, b0);
+  long to = fw_sum(ed->fw_len, b1 + 1);
+  int t0 = fw_sum(ed->fw_toks, b0);
+  int t1 = fw_sum(ed->fw_toks, b1 + 1);
+  long len = to - from + delta;
+
+  // the span's tokens: those kept before, the fresh ones, those moved after
+  span->count = 0;
+  tokbuf_reserve(span, (first - t0) + fresh->count + (t1 - old));
+  TokCur c;
+  cur_seek(ed, t0, &c);
+  for (int g = t0; g < t1; g++, cur_next(ed, &c)) {
+    if (g == first) {
+      int n = fresh->count;
+      memcpy(span->kind + span->count, fresh->kind, sizeof(uint8_t) * n);
+      memcpy(span->off + span->count, fresh->off, sizeof(uint32_t) * n);
+      memcpy(span->len + span->count, fresh->len, sizeof(uint32_t) * n);
+      memcpy(span->val + span->count, fresh->val, sizeof(int32_t) * n);
+      span->count += n;
+    }
+    if (g >= first && g < old) {
+      continue;
+    }
+    int i = span->count++;
+    TokenBuf *toks = cur_toks(ed, &c);
+    span->kind[i] = toks->kind[c.i];
+    span->off[i] = cur_off(ed, &c) + (g >= old ? delta : 0);
+    span->len[i] = toks->len[c.i];
+    span->val[i] = toks->val[c.i];
+  }
+  if (first == t1) {
+    int n = fresh->count;
+    memcpy(span->kind + span->count, fresh->kind, sizeof(uint8_t) * n);
+    memcpy(span->off + span->count, fresh->off, sizeof(uint32_t) * n);
+    memcpy(span->len + span->count, fresh->len, sizeof(uint32_t) * n);
+    memcpy(span->val + span->count, fresh->val, sizeof(int32_t) * n);
+    span->count += n;
+  }
+
+  char *text = malloc(len + 1);
+  edited_copy(ed, e, from, from + len, text);
+
+  int k = b1 - b0 + 1;
+  int nk = k;
+  if (len > (long)k * 2 * BLOCK || (k > 1 && len < (long)k * BLOCK / 4)) {
+    nk = len / BLOCK + 1;
+  }
+
+  if (nk == k) {
+    long *oldlen = malloc(sizeof(long) * 3 * k);
+    for (int j = 0; j < k; j++) {
+      oldlen[3 * j] = ed->blocks[b0 + j]->len;
+      oldlen[3 * j + 1] = ed->blocks[b0 + j]->toks.count;
+      oldlen[3 * j + 2] = ed->blocks[b0 + j]->nls;
+    }
+    fill_blocks(ed, b0, k, text, len, span, 0, from);
+    for (int j = 0; j < k; j++) {
+      Block *blk = ed->blocks[b0 + j];
+      fw_add(ed->fw_len, ed->nblocks, b0 + j, blk->len - oldlen[3 * j]);
+      fw_add(ed->fw_toks, ed->nblocks, b0 + j,
+             blk->toks.count - oldlen[3 * j + 1]);
+      fw_add(ed->fw_nls, ed->nblocks, b0 + j, blk->nls - oldlen[3 * j + 2]);
+    }
+    free(oldlen);
+  } else {
+    // a rare resplit; the block array and the trees are rebuilt
+    for (int j = nk; j < k; j++) {
+      block_free(ed->blocks[b0 + j]);
+    }
+    if (ed->nblocks + nk - k > ed->capblocks) {
+      ed->capblocks = (ed->nblocks + nk - k) * 2;
+      ed->blocks = realloc(ed->blocks, sizeof(Block *) * ed->capblocks);
+    }
+    memmove(ed->blocks + b0 + nk, ed->blocks + b1 + 1,
+            sizeof(Block *) * (ed->nblocks - b1 - 1));
+    for (int j = k; j < nk; j++) {
+      ed->blocks[b0 + j] = calloc(1, sizeof(Block));
+    }
+    ed->nblocks += nk - k;
+    fill_blocks(ed, b0, nk, text, len, span, 0, from);
+    fw_build(ed);
+  }
+  free(text);
+  ed->ntoks += fresh->count - (old - first);
+}
+
+void scan_edit_begin(Scanner *sc, TokenBuf *toks) {
+  EditState *ed = calloc(1, sizeof(EditState));
+
+  sc->edits = ed;
+  ed->nblocks = sc->len / BLOCK + 1;
+  ed->capblocks = ed->nblocks * 2;
+  ed->blocks = malloc(sizeof(Block *) * ed->capblocks);
+  for (int b = 0; b < ed->nblocks; b++) {
+    ed->blocks[b] = calloc(1, sizeof(Block));
+  }
+  fill_blocks(ed, 0, ed->nblocks, sc->buf, sc->len, toks, 0, 0);
+  ed->ntoks = toks->count;
+  fw_build(ed);
+  tokbuf_init(&ed->fresh);
+  tokbuf_init(&ed->span);
+
+  if (sc->last_close == -2) {
+    sc->last_close = last_cmt_close(sc->buf, 0, sc->len);
+  }
+
+  // from here on the blocks are the input; scan_text() rebuilds a flat copy
+  if (sc->mapped) {
+    munmap(sc->buf, sc->len);
+  } else {
+    free(sc->buf);
+  }
+  sc->buf = NULL;
+  sc->mapped = 0;
+  free(sc->nl_index);
+  sc->nl_index = NULL;
+  sc->nl_count = -1;
+  sc->pos = sc->len;
+  sc->done = 1;
+}
+
+TokEdit scan_edit(Scanner *sc, long start, long oldlen, const char *text,
+                  long newlen) {
+  EditState *ed = sc->edits;
+  Edit e = {start, oldlen, text, newlen};
+  TokEdit edit;
+
+  free(sc->buf);
+  sc->buf = NULL;
+
+  long was_unclosed = sc->last_close < 1 ? 0 : sc->last_close - 1;
+
+  // openers from cmt_unclosed on have no star-slash after them, which
+  // depends only on the last star-slash in the input
+  sc->last_close = edit_last_close(sc, &e, sc->last_close);
+  sc->cmt_unclosed = sc->last_close < 1 ? 0 : sc->last_close - 1;
+
+  // openers before the edit and between the old and new cmt_unclosed have
+  // changed between being a comment and being scanned as tokens
+  long lo = was_unclosed < sc->cmt_unclosed ? was_unclosed : sc->cmt_unclosed;
+  long hi = was_unclosed < sc->cmt_unclosed ? sc->cmt_unclosed : was_unclosed;
+  long from = edit_first_opener(sc, &e, lo, hi < start ? hi : start);
+  if (from < 0) {
+    from = start;
+  }
+
+  int first = first_affected(ed, from);
+  long pos0 = 0;
+  if (first > 0) {
+    TokCur c;
+    cur_seek(ed, first - 1, &c);
+    pos0 = cur_off(ed, &c) + cur_toks(ed, &c)->len[c.i];
+  }
+
+  // scan through a window of the edited text, larger until it holds every
+  // token scanned again
+  long len = sc->len + newlen - oldlen;
+  long wlen = start + newlen - pos0 + 1024;
+  int old;
+  for (;;) {
+    if (wlen > len - pos0) {
+      wlen = len - pos0;
+    }
+    old = first;
+    if (rescan(sc, &e, pos0, wlen, &old)) {
+      break;
+    }
+    wlen *= 2;
+  }
+
+  apply_edit(sc, &e, pos0, first, old);
+
+  edit.first = first;
+  edit.removed = old - first;
+  edit.added = ed->fresh.count;
+  sc->len = len;
+  sc->pos = len;
+  return edit;
+}
+
+int scan_edit_tokens(Scanner *sc, TokenBuf *toks) {
+  EditState *ed = sc->edits;
+  long base = 0;
+
+  tokbuf_reserve(toks, ed->ntoks);
+  for (int b = 0; b < ed->nblocks; b++) {
+    TokenBuf *bt = &ed->blocks[b]->toks;
+    int n = toks->count;
+    memcpy(toks->kind + n, bt->kind, sizeof(uint8_t) * bt->count);
+    memcpy(toks->len + n, bt->len, sizeof(uint32_t) * bt->count);
+    memcpy(toks->val + n, bt->val, sizeof(int32_t) * bt->count);
+    for (int i = 0; i < bt->count; i++) {
+      toks->off[n + i] = base + bt->off[i];
+    }
+    toks->count += bt->count;
+    base += ed->blocks[b]->len;
+  }
+  return toks->count;
+}
+
+/*
+ * edit_text() - rebuilds the flat copy of the edited input for scan_text()
+ */
+void edit_text(Scanner *sc) {
+  sc->buf = malloc(sc->len + 1);
+  text_copy(sc->edits, 0, sc->len, sc->buf);
+  sc->buf[sc->len] = '\0';
+}
+
+/*
+ * edit_lines_before() - the number of newlines before off in the edited
+ *                       input
+ */
+long edit_lines_before(Scanner *sc, long off) {
+  EditState *ed = sc->edits;
+  int b = block_at(ed, off);
+  long base = fw_sum(ed->fw_len, b);
+  long in = off - base < ed->blocks[b]->len ? off - base : ed->blocks[b]->len;
+
+  return fw_sum(ed->fw_nls, b) + count_newlines(ed->blocks[b]->text, 0, in);
+}
+
+/*
+ * edit_newline() - the offset of the newline with index n in the edited
+ *                  input, counting from 0
+ */
+long edit_newline(Scanner *sc, long n) {
+  EditState *ed = sc->edits;
+  int b = fw_find(ed->fw_nls, ed->nblocks, n);
+  Block *blk = ed->blocks[b];
+  long skip = n - fw_sum(ed->fw_nls, b);
+  long pos = 0;
+
+  for (;; pos++) {
+    if (blk->text[pos] == '\n' && skip-- == 0) {
+      break;
+    }
+  }
+  return fw_sum(ed->fw_len, b) + pos;
+}
+
+/*
+ * edit_free() - frees the blocks of an edited input
+ */
+void edit_free(Scanner *sc) {
+  EditState *ed = sc->edits;
+
+  for (int b = 0; b < ed->nblocks; b++) {
+    block_free(ed->blocks[b]);
+  }
+  free(ed->blocks);
+  free(ed->fw_len);
+  free(ed->fw_toks);
+  free(ed->fw_nls);
+  free(ed->win);
+  tokbuf_free(&ed->fresh);
+  tokbuf_free(&ed->span);
+  free(ed);
+  sc->edits = NULL;
+}
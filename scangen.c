@@ -0,0 +1,264 @@
+/*
+ * Author: Edward Fattell
+ * File: scangen.c
+ * Purpose: Generates the tables used by the table-driven scanner in
+ *          scanner.c.  The fixed-spelling tokens from scanner.h are folded
+ *          into a DFA together with the ID and INTCON classes, and the
+ *          character-class table, transition matrix, accepting states,
+ *          keyword list and keyword perfect hash are written to stdout as C
+ *          source (scantab.h).
+ */
+#include "scanner.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXSTATES 64
+#define MAXCLASSES 32
+
+// States with fixed meanings; the rest are allocated for operator prefixes
+#define ST_DEAD 0
+#define ST_START 1
+#define ST_ID 2
+#define ST_INTCON 3
+
+// Character classes with fixed meanings
+#define CL_OTHER 0
+#define CL_ALPHA 1
+#define CL_DIGIT 2
+
+struct pattern {
+  char *text;
+  Token toke;
+} typedef pattern;
+
+/*
+ * Tokens of scanner.h that have a single fixed spelling, other than keywords
+ */
+pattern patterns[] = {
+    {"(", LPAREN}, {")", RPAREN},  {"{", LBRACE},  {"}", RBRACE},
+    {",", COMMA},  {";", SEMI},    {"=", opASSG},  {"+", opADD},
+    {"-", opSUB},  {"*", opMUL},   {"/", opDIV},   {"==", opEQ},
+    {"!=", opNE},  {">", opGT},    {">=", opGE},   {"<", opLT},
+    {"<=", opLE},  {"&&", opAND},  {"||", opOR},   {"!", opNOT},
+};
+
+/*
+ * Keywords are scanned as IDs and then looked up by the scanner
+ */
+pattern keywords[] = {
+    {"int", kwINT},     {"if", kwIF},         {"else", kwELSE},
+    {"while", kwWHILE}, {"return", kwRETURN},
+};
+
+char *token_name[] = {
+    "UNDEF",  "ID",    "INTCON", "LPAREN", "RPAREN", "LBRACE",  "RBRACE",
+    "COMMA",  "SEMI",  "kwINT",  "kwIF",   "kwELSE", "kwWHILE", "kwRETURN",
+    "opASSG", "opADD", "opSUB",  "opMUL",  "opDIV",  "opEQ",    "opNE",
+    "opGT",   "opGE",  "opLT",   "opLE",   "opAND",  "opOR",    "opNOT",
+};
+
+int charclass[256];
+int nclasses = CL_DIGIT + 1;
+
+#define NKEYWORDS (sizeof(keywords) / sizeof(keywords[0]))
+#define MAXKWSIZE 64
+
+int next[MAXSTATES][MAXCLASSES];
+int accept[MAXSTATES];
+int nstates = ST_INTCON + 1;
+
+// Perfect hash for keywords: slot = (first * kwmult + last + len) & kwmask
+int kwmult;
+int kwmask;
+int kwslot[MAXKWSIZE];
+
+/*
+ * build_classes() - gives every character that appears in a pattern its own
+ *                   class; letters, '_' and digits share the ID/INTCON classes
+ */
+void build_classes() {
+  for (int ch = 0; ch < 256; ch++) {
+    if (isalpha(ch) || ch == '_') {
+      charclass[ch] = CL_ALPHA;
+    } else if (isdigit(ch)) {
+      charclass[ch] = CL_DIGIT;
+    } else {
+      charclass[ch] = CL_OTHER;
+    }
+  }
+
+  for (int i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+    for (char *p = patterns[i].text; *p; p++) {
+      if (charclass[(unsigned char)*p] == CL_OTHER) {
+        charclass[(unsigned char)*p] = nclasses++;
+      }
+    }
+  }
+}
+
+/*
+ * build_dfa() - adds the ID and INTCON loops, then threads each pattern
+ *               through the trie of operator prefixes
+ */
+void build_dfa() {
+  memset(next, 0, sizeof(next));
+  for (int s = 0; s < MAXSTATES; s++) {
+    accept[s] = -1;
+  }
+
+  next[ST_START][CL_ALPHA] = ST_ID;
+  next[ST_ID][CL_ALPHA] = ST_ID;
+  next[ST_ID][CL_DIGIT] = ST_ID;
+  accept[ST_ID] = ID;
+
+  next[ST_START][CL_DIGIT] = ST_INTCON;
+  next[ST_INTCON][CL_DIGIT] = ST_INTCON;
+  accept[ST_INTCON] = INTCON;
+
+  // a digit run followed by an ID character continues as one ID, e.g.
+  // "123_ty56" (see tests/wasIntConNowID)
+  next[ST_INTCON][CL_ALPHA] = ST_ID;
+
+  for (int i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+    int state = ST_START;
+
+    for (char *p = patterns[i].text; *p; p++) {
+      int cl = charclass[(unsigned char)*p];
+
+      if (next[state][cl] == ST_DEAD) {
+        if (nstates == MAXSTATES) {
+          fprintf(stderr, "scangen: too many states\n");
+          exit(1);
+        }
+        next[state][cl] = nstates++;
+      }
+      state = next[state][cl];
+    }
+    accept[state] = patterns[i].toke;
+  }
+}
+
+int kwhash(char *text, int mult, int mask) {
+  int len = strlen(text);
+  return ((unsigned char)text[0] * mult + (unsigned char)text[len - 1] + len) &
+         mask;
+}
+
+/*
+ * build_kwhash() - searches for the smallest power-of-two table and
+ *                  multiplier that place every keyword in its own slot
+ */
+void build_kwhash() {
+  for (int size = 1; size <= MAXKWSIZE; size *= 2) {
+    if (size < NKEYWORDS) {
+      continue;
+    }
+    for (int mult = 1; mult < 256; mult++) {
+      int collide = 0;
+
+      for (int i = 0; i < size; i++) {
+        kwslot[i] = -1;
+      }
+      for (int i = 0; i < NKEYWORDS && !collide; i++) {
+        int slot = kwhash(keywords[i].text, mult, size - 1);
+        if (kwslot[slot] >= 0) {
+          collide = 1;
+        }
+        kwslot[slot] = i;
+      }
+
+      if (!collide) {
+        kwmult = mult;
+        kwmask = size - 1;
+        return;
+      }
+    }
+  }
+  fprintf(stderr, "scangen: no perfect hash for keywords\n");
+  exit(1);
+}
+
+void print_tables() {
+  printf("/*\n"
+         " * File: scantab.h\n"
+         " * Purpose: Scanner tables generated by scangen from scanner.h.\n"
+         " *          Do not edit; rerun make instead.\n"
+         " */\n\n");
+  printf("#ifndef __SCANTAB_H__\n#define __SCANTAB_H__\n\n");
+  printf("#define SCAN_NSTATES %d\n", nstates);
+  printf("#define SCAN_NCLASSES %d\n", nclasses);
+  printf("#define SCAN_DEAD %d\n", ST_DEAD);
+  printf("#define SCAN_START %d\n\n", ST_START);
+
+  printf("/* character -> character class */\n");
+  printf("static const unsigned char scan_class[256] = {");
+  for (int ch = 0; ch < 256; ch++) {
+    printf("%s%d,", ch % 16 ? " " : "\n    ", charclass[ch]);
+  }
+  printf("\n};\n\n");
+
+  printf("/* state x character class -> state; %d is the dead state */\n",
+         ST_DEAD);
+  printf("static const unsigned char "
+         "scan_next[SCAN_NSTATES][SCAN_NCLASSES] = {\n");
+  for (int s = 0; s < nstates; s++) {
+    printf("    {");
+    for (int cl = 0; cl < nclasses; cl++) {
+      printf("%s%d", cl ? ", " : "", next[s][cl]);
+    }
+    printf("},\n");
+  }
+  printf("};\n\n");
+
+  printf("/* state -> token accepted in that state, or -1 */\n");
+  printf("static const signed char scan_accept[SCAN_NSTATES] = {\n");
+  for (int s = 0; s < nstates; s++) {
+    if (accept[s] < 0) {
+      printf("    -1,\n");
+    } else {
+      printf("    %s,\n", token_name[accept[s]]);
+    }
+  }
+  printf("};\n\n");
+
+  printf("#define SCAN_NKEYWORDS %d\n\n",
+         (int)(sizeof(keywords) / sizeof(keywords[0])));
+  printf("static const struct {\n  char *text;\n  int len;\n  Token toke;\n}"
+         " scan_keywords[SCAN_NKEYWORDS] = {\n");
+  for (int i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    printf("    {\"%s\", %d, %s},\n", keywords[i].text,
+           (int)strlen(keywords[i].text), token_name[keywords[i].toke]);
+  }
+  printf("};\n\n");
+
+  printf("/* perfect hash of an identifier slice into scan_kwtab */\n");
+  printf("#define SCAN_KWHASH(text, len) \\\n"
+         "  (((unsigned char)(text)[0] * %d + (unsigned char)(text)[(len)-1] + "
+         "(len)) & %d)\n\n",
+         kwmult, kwmask);
+  printf("static const struct {\n  char *text;\n  int len;\n  Token toke;\n}"
+         " scan_kwtab[%d] = {\n",
+         kwmask + 1);
+  for (int i = 0; i <= kwmask; i++) {
+    if (kwslot[i] < 0) {
+      printf("    {\"\", 0, ID},\n");
+    } else {
+      printf("    {\"%s\", %d, %s},\n", keywords[kwslot[i]].text,
+             (int)strlen(keywords[kwslot[i]].text),
+             token_name[keywords[kwslot[i]].toke]);
+    }
+  }
+  printf("};\n\n");
+
+  printf("#endif /* __SCANTAB_H__ */\n");
+}
+
+int main() {
+  build_classes();
+  build_dfa();
+  build_kwhash();
+  print_tables();
+  return 0;
+}
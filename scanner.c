@@ -3,558 +3,414 @@
  * Date: 4 February 2025
  * Purpose: scanner is a basic implementation of a scanner for the G0
  *          subset of C that mainly implements the function get_char
- *          to be used to get tokens from stdin to be used with a parser
- *          at a later date
+ *          to be used to get tokens from its input to be used with a parser
+ *          at a later date.  Tokens are recognized by the DFA whose tables
+ *          scangen generates into scantab.h.
  *
- *          NOTE: This implementation puts characters from unclosed comments
- *                back onto stdin as discussed in class with Dr. Debray
+ *          All scanning state lives in a Scanner, so separate scanners may
+ *          be used from separate threads at once.
+ *
+ *          NOTE: This implementation scans the characters of unclosed
+ *                comments as tokens, as discussed in class with Dr. Debray
  */
 #include "scanner.h"
-#include <ctype.h>
+#include "intern.h"
+#include "scansimd.h"
+#include "scantab.h"
+#include <limits.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-char *lexeme;
-int lval;
 int BUFSZ = sizeof(char) * 1024;
-int linecnt = 1;
-
-struct tokenNode {
-  Token toke;
-  char *pattern;
-  struct tokenNode *next;
-} typedef tokenNode;
-
-tokenNode *tokenTable = NULL;
 
-int isIDChar(char ch);
+#define READ_CHUNK (sizeof(char) * 65536)
 
-void buildTable();
+// The kernels in scansimd.c are chosen once for every scanner in the process
+pthread_once_t simd_once = PTHREAD_ONCE_INIT;
 
-void freetable();
+int rm_cmt(Scanner *sc);
+void edit_text(Scanner *sc);
+long edit_lines_before(Scanner *sc, long off);
+long edit_newline(Scanner *sc, long n);
+void edit_free(Scanner *sc);
 
-tokenNode *guessToken(char *buf, int idx, tokenNode *prevGuess);
-
-int rm_cmt(int buflen);
+/*
+ * scanner_alloc() - returns a scanner with no input and an empty intern pool
+ */
+Scanner *scanner_alloc() {
+  Scanner *sc = calloc(1, sizeof(Scanner));
+
+  pthread_once(&simd_once, scan_simd_init);
+  intern_init(&sc->ids);
+  sc->cmt_unclosed = -1;
+  sc->last_close = -2;
+  sc->nl_count = -1;
+  return sc;
+}
 
 /*
- * get_token() - returns a token enum value corresponding to the lexeme it finds
- * on stdin
+ * scanner_create() - returns a scanner over everything readable from fd.  A
+ *                    regular file is mmapped; pipes and terminals are read in
+ *                    large chunks into a buffer that doubles as it fills.
  */
-int get_token() {
-  atexit(freetable);
-  free(lexeme);
-  lexeme = NULL;
-  lval = 0;
-  char ch;
-  char buf[BUFSZ];
-  // fill buffer with nulls (used for strlen later in guessToken)
-  memset(buf, '\0', sizeof(buf));
-
-  int idx = 0;
-  char *ptr = buf;
-
-  // Pointer to token node in table
-  tokenNode *tokenGuess = tokenTable;
-
-  while ((ch = getchar()) != EOF) {
-    // printf("Char: %c\n", ch);
-    if (tokenGuess) {
-    } else {
-    }
-    int removedSpaced = 0;
-    ungetc(ch, stdin);
-    removedSpaced = rm_cmt(strlen(buf));
-
-    if (removedSpaced && strlen(buf) > 0) {
-      if (tokenGuess == NULL) {
-        continue;
-      }
-      if (strlen(buf) == strlen(tokenGuess->pattern) ||
-          !strcmp(tokenGuess->pattern, "")) {
-        lexeme = strdup(buf);
-        return tokenGuess->toke;
-      }
-      tokenGuess = tokenGuess->next;
-      tokenGuess = guessToken(buf, idx, tokenGuess);
-      // printf("guessing new token\n");
-
-      lexeme = strdup(buf);
-      return tokenGuess->toke;
+Scanner *scanner_create(int fd) {
+  Scanner *sc = scanner_alloc();
+  struct stat st;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      sc->buf = map;
+      sc->len = st.st_size;
+      sc->mapped = 1;
+      return sc;
     }
+  }
 
-    char newCh = getchar();
-    ch = newCh;
-    // printf("New Char: %c\n", ch);
-    if (strlen(buf) == 0) {
-      removedSpaced = 0;
-    }
-    if (!tokenGuess && strlen(buf) == 1) {
-      ungetc(ch, stdin);
-      lexeme = strdup(buf);
-      // printf("returning undef\n");
-      return UNDEF;
-    }
-    *ptr = ch;
-    tokenGuess = guessToken(buf, idx, tokenGuess);
-
-    if (*ptr == '\0') {
-      lexeme = strdup(buf);
-      if (tokenGuess == NULL) {
-        continue;
-      }
-      return tokenGuess->toke;
+  long cap = READ_CHUNK;
+  sc->buf = malloc(cap);
+  sc->len = 0;
+
+  ssize_t nread;
+  while ((nread = read(fd, sc->buf + sc->len, cap - sc->len)) > 0) {
+    sc->len += nread;
+    if (sc->len == cap) {
+      cap *= 2;
+      sc->buf = realloc(sc->buf, cap);
     }
+  }
+  return sc;
+}
 
-    *ptr = ch;
+/*
+ * scanner_create_text() - returns a scanner over a private copy of len bytes
+ *                         of text
+ */
+Scanner *scanner_create_text(const char *text, long len) {
+  Scanner *sc = scanner_alloc();
+
+  sc->buf = malloc(len + 1);
+  memcpy(sc->buf, text, len);
+  sc->len = len;
+  return sc;
+}
 
-    ptr++;
-    idx++;
+/*
+ * scanner_destroy() - frees the lexeme buffer, the input buffer, the newline
+ *                     index and the interned identifier names
+ */
+void scanner_destroy(Scanner *sc) {
+  if (sc == NULL) {
+    return;
   }
-  if (strlen(buf)) {
-    if (tokenGuess) {
-      if (!strcmp(buf, tokenGuess->pattern))
-        return tokenGuess->toke;
-    }
-    // return UNDEF;
+  free(sc->lexbuf);
+  if (sc->edits != NULL) {
+    edit_free(sc);
   }
-  return -1;
+  if (sc->mapped) {
+    munmap(sc->buf, sc->len);
+  } else {
+    free(sc->buf);
+  }
+  intern_free(&sc->ids);
+  free(sc->nl_index);
+  free(sc);
 }
 
 /*
- * isIDChar() - helper function to determine if a char is a candidate for
- *              an ID lexeme
- *            char ch is the char to check
- *            returns boolean value of candidacy
+ * set_lexeme() - copies the current token's slice into the reusable lexeme
+ *                buffer for callers of get_token()
  */
-int isIDChar(char ch) {
-  if (isalnum(ch) || ch == '_') {
-    return 1;
+void set_lexeme(Scanner *sc) {
+  if (sc->tok_len + 1 > sc->lexcap) {
+    sc->lexcap = sc->tok_len + 1 > BUFSZ ? sc->tok_len + 1 : BUFSZ;
+    sc->lexbuf = realloc(sc->lexbuf, sc->lexcap);
   }
-  return 0;
+  memcpy(sc->lexbuf, sc->buf + sc->tok_off, sc->tok_len);
+  sc->lexbuf[sc->tok_len] = '\0';
+  sc->lexeme = sc->lexbuf;
 }
 
 /*
- * guessToken() is the main helper gunction for get_token
- *              it infers the lexeme and token of a buffer
- *              based on the "token table"
+ * scan_text() - returns the start of the input buffer that token slices
+ *               index into, rebuilding it if an edit has dropped it
  */
-tokenNode *guessToken(char *buf, int idx, tokenNode *prevGuess) {
-  if (!tokenTable) {
-    buildTable();
-  }
-  if (prevGuess == NULL) {
-    prevGuess = tokenTable;
+const char *scan_text(Scanner *sc) {
+  if (sc->buf == NULL && sc->edits != NULL) {
+    edit_text(sc);
   }
+  return sc->buf;
+}
 
-  tokenNode *nextGuess = prevGuess;
-  tokenNode *matchedToken = NULL;
-
-  // iterate through all lexemes in the table until one is found that matches
-  // the buf
-  int restart = 0;
-  for (nextGuess = prevGuess; 1; nextGuess = nextGuess->next) {
+/*
+ * keyword() - returns the keyword token spelled by an identifier slice, or ID.
+ *             The generated perfect hash picks the only keyword that could
+ *             match, so at most one comparison is made.
+ */
+Token keyword(const char *text, int len) {
+  int slot = SCAN_KWHASH(text, len);
 
-    int i = 0;
-    if (!restart) {
-      i = strlen(buf) - 1;
-    }
+  if (scan_kwtab[slot].len == len && !memcmp(scan_kwtab[slot].text, text, len)) {
+    return scan_kwtab[slot].toke;
+  }
+  return ID;
+}
 
-    if (nextGuess == NULL) {
-      if (strlen(buf) == 1) {
-        return NULL;
-      }
-      nextGuess = prevGuess->next;
-      ungetc(buf[strlen(buf) - 1], stdin);
-      buf[strlen(buf) - 1] = '\0';
-      i = 0;
-
-      if (strlen(buf) < 1) {
-        return NULL;
-      } else if (strlen(buf) == 1) {
-        return prevGuess;
-      }
-    }
+/*
+ * decode_intcon() - returns the value of the len decimal digits at text in a
+ *                   single pass, or -1 if it is larger than INT_MAX
+ */
+int decode_intcon(const char *text, int len) {
+  long long val = 0;
 
-    for (i = i; i < strlen(buf); i++) {
-      // if current guess is int constant, than must check using isdigit
-      int wasIntCon = 0;
-      if (nextGuess->toke == INTCON) {
-        if (isdigit(buf[i])) {
-          lval = lval * 10 + atoi(buf + idx);
-          matchedToken = nextGuess;
-          return matchedToken;
-        } else if (strlen(buf) > 1 && i > 0) {
-          // if it is not a digit, it might be an ID
-          wasIntCon = 1;
-        }
-      }
-
-      // if current guess is ID, than must check using isIDChar
-      if (nextGuess->toke == ID || wasIntCon) {
-        if (isIDChar(buf[i])) {
-          if (wasIntCon) {
-            nextGuess = nextGuess->next;
-          }
-          if (strlen(buf) == i + 1) {
-            matchedToken = nextGuess;
-            for (tokenNode *cur = tokenTable; cur != NULL; cur = cur->next) {
-              if (!strcmp(buf, cur->pattern)) {
-                return cur;
-              }
-            }
-            return matchedToken;
-          } else {
-            continue;
-          }
-
-        } else if (wasIntCon) {
-          ungetc(buf[strlen(buf) - 1], stdin);
-          buf[strlen(buf) - 1] = '\0';
-          for (tokenNode *cur = tokenTable; cur != NULL; cur = cur->next) {
-            if (!strcmp(buf, cur->pattern)) {
-              return cur;
-            }
-          }
-          return nextGuess;
-
-        } else if (strlen(buf) - 1 >= 1 && i > 0) {
-          // printf("unget ID branch ungetting %c \n", buf[strlen(buf) - 1]);
-          ungetc(buf[strlen(buf) - 1], stdin);
-          buf[strlen(buf) - 1] = '\0';
-          for (tokenNode *cur = tokenTable; cur != NULL; cur = cur->next) {
-            if (!strcmp(buf, cur->pattern)) {
-              return cur;
-            }
-          }
-          return nextGuess;
-        }
-      }
-
-      // For patterns that are not ID or INTCON
-      if (nextGuess->pattern[i] == buf[i] &&
-          strlen(buf) <= strlen(nextGuess->pattern)) {
-
-        matchedToken = nextGuess;
-        if (i == strlen(nextGuess->pattern) - 1 && strlen(buf) - 1 == i) {
-          return matchedToken;
-        }
-
-        if (i == strlen(buf) - 1) {
-          return matchedToken;
-        }
-      } else {
-        restart = 1;
-        break;
-      }
+  for (int i = 0; i < len; i++) {
+    val = val * 10 + (text[i] - '0');
+    if (val > INT_MAX) {
+      return -1;
     }
   }
-
-  return matchedToken;
+  return val;
 }
 
 /*
- * buildTable() - dynamically allocated and bulds table of tokens and lexemes
- *                to be used by the guessToken function
+ * scan_token() - returns the next token, storing its offset and length within
+ *                scan_text() instead of building a lexeme.  The DFA tables in
+ *                scantab.h are run from the read cursor and the longest
+ *                accepted prefix wins; a character that starts no token is
+ *                returned alone as UNDEF.
  */
-void buildTable() {
-  tokenNode *tbPtr = tokenTable;
-
-  tbPtr = malloc(sizeof(tokenNode));
-  tokenTable = tbPtr;
-  tbPtr->toke = kwINT;
-  tbPtr->pattern = strdup("int");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = kwIF;
-  tbPtr->pattern = strdup("if");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = kwELSE;
-  tbPtr->pattern = strdup("else");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = kwWHILE;
-  tbPtr->pattern = strdup("while");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = kwRETURN;
-  tbPtr->pattern = strdup("return");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opEQ;
-  tbPtr->pattern = strdup("==");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opNE;
-  tbPtr->pattern = strdup("!=");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opGE;
-  tbPtr->pattern = strdup(">=");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opLE;
-  tbPtr->pattern = strdup("<=");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opAND;
-  tbPtr->pattern = strdup("&&");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opOR;
-  tbPtr->pattern = strdup("||");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opGT;
-  tbPtr->pattern = strdup(">");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opLT;
-  tbPtr->pattern = strdup("<");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = LPAREN;
-  tbPtr->pattern = strdup("(");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = RPAREN;
-  tbPtr->pattern = strdup(")");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = LBRACE;
-  tbPtr->pattern = strdup("{");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = RBRACE;
-  tbPtr->pattern = strdup("}");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = COMMA;
-  tbPtr->pattern = strdup(",");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = SEMI;
-  tbPtr->pattern = strdup(";");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opASSG;
-  tbPtr->pattern = strdup("=");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opADD;
-  tbPtr->pattern = strdup("+");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opSUB;
-  tbPtr->pattern = strdup("-");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opMUL;
-  tbPtr->pattern = strdup("*");
-
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
-
-  tbPtr->toke = opDIV;
-  tbPtr->pattern = strdup("/");
+int scan_token(Scanner *sc, int *off, int *len) {
+  const char *buf = sc->buf;
+  sc->lval = 0;
+
+  rm_cmt(sc);
+  sc->tok_off = sc->pos;
+  sc->tok_len = 0;
+  *off = sc->tok_off;
+  *len = 0;
+  if (sc->pos >= sc->len) {
+    return EOF;
+  }
 
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
+  int state = SCAN_START;
+  int toke = UNDEF;
+  long end = sc->pos + 1;
 
-  tbPtr->toke = INTCON;
-  tbPtr->pattern = strdup("");
+  for (long pos = sc->pos; pos < sc->len; pos++) {
+    state = scan_next[state][scan_class[(unsigned char)buf[pos]]];
+    if (state == SCAN_DEAD) {
+      break;
+    }
+    if (scan_accept[state] >= 0) {
+      toke = scan_accept[state];
+      end = pos + 1;
+    }
+  }
 
-  tbPtr->next = malloc(sizeof(tokenNode));
-  tbPtr = tbPtr->next;
+  sc->tok_len = end - sc->pos;
+  sc->pos = end;
 
-  tbPtr->toke = ID;
-  tbPtr->pattern = strdup("");
+  if (toke == ID) {
+    toke = keyword(buf + sc->tok_off, sc->tok_len);
+    if (toke == ID) {
+      sc->tok_id = intern(&sc->ids, buf + sc->tok_off, sc->tok_len);
+    }
+  } else if (toke == INTCON) {
+    sc->lval = decode_intcon(buf + sc->tok_off, sc->tok_len);
+  }
 
-  tbPtr->next = NULL;
+  *len = sc->tok_len;
+  return toke;
 }
 
 /*
- * charNode is the struct to be used to store comments that were popped
- * off stdin so they can be returned to stdin in the proper order
+ * get_token() - returns a token enum value corresponding to the lexeme it finds
+ * in the scanner's input
  */
-struct charNode {
-  char ch;
-  struct charNode *next;
-} typedef charStack;
+int get_token(Scanner *sc) {
+  int off, len;
+  int toke = scan_token(sc, &off, &len);
+
+  if (toke == EOF) {
+    sc->lexeme = NULL;
+  } else if (toke == ID) {
+    // identifiers hand out their interned name rather than a copy
+    sc->lexeme = intern_name(&sc->ids, sc->tok_id);
+  } else {
+    set_lexeme(sc);
+  }
+  return toke;
+}
 
 /*
- * freeCharStack - helper function for rm_cmt that frees the char queue
+ * id_name() - returns the interned name for an ID token's id
  */
-void freeCharStack(charStack *hd) {
-  charStack *next = NULL;
+char *id_name(Scanner *sc, int id) {
+  return intern_name(&sc->ids, id);
+}
 
-  while (hd != NULL) {
-    next = hd->next;
-    free(hd);
-    hd = next;
-  }
+void tokbuf_init(TokenBuf *toks) {
+  toks->count = 0;
+  toks->cap = 1024;
+  toks->kind = malloc(sizeof(uint8_t) * toks->cap);
+  toks->off = malloc(sizeof(uint32_t) * toks->cap);
+  toks->len = malloc(sizeof(uint32_t) * toks->cap);
+  toks->val = malloc(sizeof(int32_t) * toks->cap);
+}
+
+void tokbuf_free(TokenBuf *toks) {
+  free(toks->kind);
+  free(toks->off);
+  free(toks->len);
+  free(toks->val);
+  toks->kind = NULL;
+  toks->off = NULL;
+  toks->len = NULL;
+  toks->val = NULL;
+  toks->count = 0;
+  toks->cap = 0;
 }
 
 /*
- * rm_cmt() - removes multiline comments and spaces from stdin using getchar
+ * tokbuf_reserve() - makes room for n more entries in toks
  */
-int rm_cmt(int buflen) {
-  int retVal = 0;
-
-  char chSpace;
-  while ((chSpace = getchar()) != EOF) {
-    if (!isspace(chSpace) && chSpace != 10) {
-      ungetc(chSpace, stdin);
-      break;
-    }
-    if (buflen > 0) {
-      ungetc(chSpace, stdin);
-      return 1;
-    }
-    if (chSpace == '\n') {
-      linecnt++;
-    }
-    retVal++;
+void tokbuf_reserve(TokenBuf *toks, int n) {
+  if (toks->count + n <= toks->cap) {
+    return;
+  }
+  while (toks->count + n > toks->cap) {
+    toks->cap *= 2;
   }
+  toks->kind = realloc(toks->kind, sizeof(uint8_t) * toks->cap);
+  toks->off = realloc(toks->off, sizeof(uint32_t) * toks->cap);
+  toks->len = realloc(toks->len, sizeof(uint32_t) * toks->cap);
+  toks->val = realloc(toks->val, sizeof(int32_t) * toks->cap);
+}
+
+int scan_batch(Scanner *sc, TokenBuf *toks, int max) {
+  int n;
 
-  if (chSpace == EOF) {
-    ungetc(-1, stdin);
-    return -1;
+  if (sc->done) {
+    return 0;
   }
+  tokbuf_reserve(toks, max);
 
-  charStack *hd = malloc(sizeof(charStack));
+  for (n = 0; n < max; n++) {
+    int off, len;
+    int toke = scan_token(sc, &off, &len);
+    int i = toks->count++;
 
-  hd->ch = getchar();
-  hd->next = NULL;
+    toks->kind[i] = toke == EOF ? TOK_EOF : toke;
+    toks->off[i] = off;
+    toks->len[i] = len;
+    toks->val[i] = toke == ID ? sc->tok_id : sc->lval;
 
-  if (hd->ch != '/') {
-    ungetc(hd->ch, stdin);
-    free(hd);
-    return retVal;
+    if (toke == EOF) {
+      sc->done = 1;
+      return n + 1;
+    }
   }
-  charStack *newHd = malloc(sizeof(charStack));
-
-  newHd->ch = getchar();
-  if (newHd->ch != '*') {
-    ungetc(newHd->ch, stdin);
-    ungetc(hd->ch, stdin);
-    free(newHd);
-    free(hd);
-    return retVal;
+  return n;
+}
+
+int scan_all(Scanner *sc, TokenBuf *toks) {
+  while (scan_batch(sc, toks, 4096) > 0) {
   }
+  return toks->count;
+}
 
-  newHd->next = hd;
-  hd = newHd;
+/*
+ * rm_cmt() - moves the read cursor past whitespace and multiline comments
+ *            and returns the number of bytes skipped.  A comment that is
+ *            never closed is left in place so that its characters are
+ *            scanned as tokens.  The byte scanning is done by the kernels in
+ *            scansimd.c.
+ */
+int rm_cmt(Scanner *sc) {
+  const char *buf = sc->buf;
+  long start = sc->pos;
+  long pos = sc->pos;
 
-  int wasStar = 0;
-  while (1) {
-    newHd = malloc(sizeof(charStack));
+  while (pos < sc->len) {
+    pos = skip_space(buf, pos, sc->len);
 
-    if ((newHd->ch = getchar()) == EOF) {
-      free(newHd);
+    if (pos + 1 >= sc->len || buf[pos] != '/' || buf[pos + 1] != '*') {
       break;
     }
-
-    newHd->next = hd;
-    hd = newHd;
-
-    if (wasStar) {
-      if (hd->ch == '/') {
-        retVal++;
-        freeCharStack(hd);
-        // must recurse to account for additional spaces or comments following
-        // the one just found
-        return retVal + rm_cmt(buflen);
-      }
+    if (sc->cmt_unclosed >= 0 && pos >= sc->cmt_unclosed) {
+      break;
     }
 
-    if (hd->ch == '\n') {
-      linecnt++;
-    }
-    if (hd->ch == '*') {
-      wasStar = 1;
-    } else {
-      wasStar = 0;
+    long close = find_cmt_close(buf, pos + 2, sc->len);
+    if (close < 0) {
+      // rewind: nothing past here closes a comment
+      sc->cmt_unclosed = pos;
+      break;
     }
+    pos = close + 2;
   }
 
-  // comment pattern not found, so must put chars next on stack
-  charStack *next = NULL;
+  sc->pos = pos;
+  return pos - start;
+}
 
-  while (hd != NULL) {
-    next = hd->next;
-    if (hd->ch == '\n') {
-      linecnt--;
-    }
-    ungetc(hd->ch, stdin);
-    free(hd);
-    hd = next;
+/*
+ * build_nl_index() - records the offset of every newline in the input, sized
+ *                    up front by the newline-counting kernel
+ */
+void build_nl_index(Scanner *sc) {
+  sc->nl_count = count_newlines(sc->buf, 0, sc->len);
+  sc->nl_index = malloc(sizeof(uint32_t) * (sc->nl_count + 1));
+
+  long n = 0;
+  char *p = sc->buf;
+  char *end = sc->buf + sc->len;
+  while ((p = memchr(p, '\n', end - p)) != NULL) {
+    sc->nl_index[n++] = p - sc->buf;
+    p++;
   }
-  return retVal;
 }
 
 /*
- * freetable() - frees the token table as well as the lexeme buffer
+ * lines_before() - returns the number of newlines before offset off, by
+ *                  binary search of the newline index
  */
-void freetable() {
-  tokenNode *hd = tokenTable;
-  tokenNode *next = NULL;
-
-  while (hd != NULL) {
-    next = hd->next;
-    free(hd->pattern);
-    free(hd);
-    hd = next;
+long lines_before(Scanner *sc, long off) {
+  if (sc->edits != NULL) {
+    return edit_lines_before(sc, off);
+  }
+  if (sc->nl_count < 0) {
+    build_nl_index(sc);
   }
 
-  free(lexeme);
-  tokenTable = NULL;
-  lexeme = NULL;
+  long lo = 0;
+  long hi = sc->nl_count;
+  while (lo < hi) {
+    long mid = lo + (hi - lo) / 2;
+    if (sc->nl_index[mid] < off) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+int src_line(Scanner *sc, long off) {
+  return lines_before(sc, off) + 1;
+}
+
+int src_col(Scanner *sc, long off) {
+  long n = lines_before(sc, off);
+  if (n == 0) {
+    return off + 1;
+  }
+  return off - (sc->edits != NULL ? edit_newline(sc, n - 1)
+                                  : sc->nl_index[n - 1]);
 }
@@ -7,7 +7,8 @@
 #ifndef __SCANNER_H__
 #define __SCANNER_H__
 
-extern int lval;
+#include "intern.h"
+#include <stdint.h>
 
 /*
  * The enum Token defines integer values for the various tokens.  These
@@ -44,6 +45,154 @@ typedef enum {
   opNOT /* ! : Op: logical-not */
 } Token;
 
-int get_token();
+/*
+ * A Scanner holds everything needed to tokenize one input: the input itself,
+ * the read cursor, the interned identifier names and the most recent token.
+ * Scanners share no mutable state, so each may be used by its own thread;
+ * a single Scanner must not be used by two threads at once.
+ */
+struct scanner {
+  char *buf;         /* the whole input; see scan_edit_begin() */
+  long len;          /* bytes in buf */
+  long pos;          /* read cursor */
+  int mapped;        /* buf is mmapped rather than malloced */
+  long cmt_unclosed; /* no comment opener from here on has a close, or -1 */
+  long last_close;   /* offset of the last star-slash, -1 if none, -2 if
+                        not known yet; kept by scan_edit() */
+  uint32_t *nl_index; /* offsets of every newline, built on first lookup */
+  long nl_count;     /* entries in nl_index, or -1 until it is built */
+  int done;          /* scan_batch() has appended the TOK_EOF entry */
+  InternPool ids;    /* identifier names */
+  struct editstate *edits; /* the input in blocks, once scan_edit_begin() has
+                              run; see scanedit.c */
+
+  /* the most recent token */
+  int tok_off;       /* offset of its lexeme in buf */
+  int tok_len;       /* length of its lexeme */
+  int tok_id;        /* interned id, for an ID */
+  int lval;          /* value, for an INTCON */
+  char *lexeme;      /* set by get_token(); see below */
+  char *lexbuf;      /* storage for lexeme, reused between tokens */
+  int lexcap;
+} typedef Scanner;
+
+/*
+ * scanner_create() reads everything from fd, mapping it when it is a regular
+ * file; scanner_create_text() copies len bytes of text instead.  Either way
+ * the scanner owns its input until scanner_destroy(), which frees the scanner
+ * and everything it handed out, interned names included.
+ */
+Scanner *scanner_create(int fd);
+Scanner *scanner_create_text(const char *text, long len);
+void scanner_destroy(Scanner *sc);
+
+/*
+ * get_token() returns the next token and sets sc->lexeme to its text, NULL
+ * at EOF, and sc->lval to the value of an INTCON.
+ */
+int get_token(Scanner *sc);
+
+/*
+ * scan_token() returns the next token like get_token(), but describes its
+ * lexeme as a slice (*off, *len) of the buffer returned by scan_text() rather
+ * than copying it.  The buffer holds the whole input and stays valid until
+ * the scanner is destroyed.  For an ID, sc->tok_id is set to its interned id,
+ * and get_token() sets sc->lexeme to the interned name itself, so two
+ * identifiers are the same name exactly when their lexeme pointers are
+ * equal.  For an INTCON, sc->lval is its value, or -1 if the constant does
+ * not fit in an int.
+ */
+int scan_token(Scanner *sc, int *off, int *len);
+const char *scan_text(Scanner *sc);
+
+/*
+ * decode_intcon() returns the value of the len decimal digits at text, or -1
+ * if it is larger than INT_MAX.  Each digit is read once.
+ */
+int decode_intcon(const char *text, int len);
+
+/*
+ * A TokenBuf holds a run of scanned tokens as parallel arrays, one entry per
+ * token.  kind is the Token, or TOK_EOF for the entry that ends the input;
+ * off and len give the lexeme's slice of scan_text(); val is the interned id
+ * of an ID (see id_name()) or the value of an INTCON (-1 if out of range).
+ * Lines are not tracked while scanning; src_line() recovers them from off.
+ */
+#define TOK_EOF 255
+
+struct tokenbuf {
+  uint8_t *kind;
+  uint32_t *off;
+  uint32_t *len;
+  int32_t *val;
+  int count;
+  int cap;
+} typedef TokenBuf;
+
+void tokbuf_init(TokenBuf *toks);
+void tokbuf_free(TokenBuf *toks);
+void tokbuf_reserve(TokenBuf *toks, int n);
+
+/*
+ * scan_batch() appends up to max more tokens to toks and returns how many it
+ * appended; once the TOK_EOF entry has been appended it returns 0.
+ * scan_all() appends every remaining token, TOK_EOF included, and returns the
+ * number of entries in toks.
+ */
+int scan_batch(Scanner *sc, TokenBuf *toks, int max);
+int scan_all(Scanner *sc, TokenBuf *toks);
+
+/*
+ * scan_all_parallel() appends the same tokens as scan_all(), scanning chunks
+ * of the input on nthreads threads (one per CPU if nthreads is 0).  It falls
+ * back to scan_all() for small inputs and for a scanner that has already
+ * started.  See scanpar.c.
+ */
+int scan_all_parallel(Scanner *sc, TokenBuf *toks, int nthreads);
+
+/*
+ * scan_edit_begin() prepares a scanner for editing.  toks must be the
+ * complete token array of its input, from scan_all(); the scanner keeps its
+ * own copy, split with the text into blocks, and toks may then be freed.
+ * From then on sc->buf is NULL until scan_text() rebuilds a flat copy of the
+ * input, which the next edit frees again.
+ *
+ * scan_edit() replaces the oldlen bytes at offset start of the input with
+ * newlen bytes of text and updates the tokens to match.  Only tokens near the
+ * edit are scanned again: from the last token the edit cannot affect until
+ * the new tokens line up with the old ones, plus any run of tokens a new
+ * star-slash turns back into a comment.  Later tokens are kept as they are,
+ * and only the blocks the edit touches are rewritten, so an edit costs time
+ * in its size and the tokens it changes, not in the size of the input.  A
+ * TokEdit says which entries changed: removed old entries starting at first
+ * were replaced by added new ones.  IDs keep their ids; new names get new
+ * ids.
+ *
+ * scan_edit_tokens() appends the complete token array of the edited input to
+ * toks and returns the number of entries in toks.  See scanedit.c.
+ */
+struct tokedit {
+  int first;
+  int removed;
+  int added;
+} typedef TokEdit;
+
+void scan_edit_begin(Scanner *sc, TokenBuf *toks);
+TokEdit scan_edit(Scanner *sc, long start, long oldlen, const char *text,
+                  long newlen);
+int scan_edit_tokens(Scanner *sc, TokenBuf *toks);
+
+/*
+ * src_line() and src_col() map an offset in scan_text() to its 1-based line
+ * and column.  The first call indexes every newline in the input; each call
+ * is then a binary search of that index.
+ */
+int src_line(Scanner *sc, long off);
+int src_col(Scanner *sc, long off);
+
+/*
+ * id_name() returns the interned name for the id of an ID token.
+ */
+char *id_name(Scanner *sc, int id);
 
 #endif /* __SCANNER_H__ */
@@ -0,0 +1,296 @@
+/*
+ * Author: Edward Fattell
+ * File: scanpar.c
+ * Purpose: Parallel tokenizing of one large input.  The buffer is cut into
+ *          chunks that worker threads scan speculatively, and the chunk
+ *          results are stitched together in order into the same token
+ *          stream the serial scanner produces.
+ *
+ *          A chunk boundary may fall inside a token or inside a comment, so
+ *          each chunk is scanned twice: once as if the boundary were between
+ *          tokens, and once as if it were inside a comment, starting after
+ *          the next star-slash.  Scanning from a token start depends on
+ *          nothing but that offset, so once the true stream reaches a token
+ *          start that one of the runs also has, the rest of that run is
+ *          exactly what the serial scanner would produce.
+ */
+#include "scanner.h"
+#include "scansimd.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Inputs smaller than two chunks are scanned serially
+#define PAR_MIN_CHUNK (1L << 20)
+
+// Chunks per thread, so that threads finishing early can take more work
+#define PAR_CHUNKS_PER_THREAD 4
+
+/*
+ * chunkscan holds the two speculative runs over one chunk.  Each run holds
+ * the tokens that start inside the chunk; IDs carry ids from the chunk's own
+ * intern pool until they are stitched.
+ */
+struct chunkscan {
+  long start;
+  long end;
+  TokenBuf run[2]; /* 0: boundary between tokens, 1: boundary in a comment */
+  int join;        /* index in run 0 where run 1 reached the same token */
+  InternPool ids;
+  int *idmap; /* chunk id -> id in the scanner's pool, or -1 */
+} typedef ChunkScan;
+
+struct parjob {
+  Scanner *sc;
+  ChunkScan *chunks;
+  int nchunks;
+  int next; /* next chunk to hand out, taken atomically */
+  long cmt_unclosed;
+} typedef ParJob;
+
+/*
+ * unclosed_from() - returns the offset from which a comment opener has no
+ *                   closing star-slash after it, which only depends on
+ *                   where the last star-slash in the input is
+ */
+long unclosed_from(const char *buf, long len) {
+  for (long pos = len - 2; pos >= 0; pos--) {
+    if (buf[pos] == '*' && buf[pos + 1] == '/') {
+      return pos - 1;
+    }
+  }
+  return 0;
+}
+
+int find_start(TokenBuf *toks, long off);
+
+/*
+ * scan_run() - scans from pos with the worker scanner w, keeping the tokens
+ *              that start before end.  If other is not NULL, the run stops
+ *              at the first token that also starts a token in other, since
+ *              the two runs are the same from there on; the index of that
+ *              token in other is returned, else -1.
+ */
+int scan_run(Scanner *w, long pos, long end, TokenBuf *toks, TokenBuf *other) {
+  w->pos = pos;
+
+  for (;;) {
+    int off, len;
+    int toke = scan_token(w, &off, &len);
+    if (toke == EOF || off >= end) {
+      return -1;
+    }
+    if (other != NULL) {
+      int join = find_start(other, off);
+      if (join >= 0) {
+        return join;
+      }
+    }
+
+    tokbuf_reserve(toks, 1);
+    int i = toks->count++;
+    toks->kind[i] = toke;
+    toks->off[i] = off;
+    toks->len[i] = len;
+    toks->val[i] = toke == ID ? w->tok_id : w->lval;
+  }
+}
+
+/*
+ * scan_chunk() - makes both speculative runs over a chunk
+ */
+void scan_chunk(ParJob *job, ChunkScan *chunk) {
+  Scanner w;
+
+  memset(&w, 0, sizeof(w));
+  w.buf = job->sc->buf;
+  w.len = job->sc->len;
+  w.cmt_unclosed = job->cmt_unclosed;
+  w.nl_count = -1;
+  intern_init(&w.ids);
+
+  tokbuf_init(&chunk->run[0]);
+  tokbuf_init(&chunk->run[1]);
+  scan_run(&w, chunk->start, chunk->end, &chunk->run[0], NULL);
+
+  // only a closer inside the chunk can start the second run
+  chunk->join = -1;
+  long close = find_cmt_close(w.buf, chunk->start, chunk->end);
+  if (close >= 0 && close + 2 < chunk->end) {
+    chunk->join = scan_run(&w, close + 2, chunk->end, &chunk->run[1],
+                           &chunk->run[0]);
+  }
+
+  chunk->ids = w.ids;
+  chunk->idmap = malloc(sizeof(int) * (chunk->ids.count + 1));
+  for (int i = 0; i < chunk->ids.count; i++) {
+    chunk->idmap[i] = -1;
+  }
+}
+
+void *par_worker(void *arg) {
+  ParJob *job = arg;
+  int i;
+
+  while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) <
+         job->nchunks) {
+    scan_chunk(job, &job->chunks[i]);
+  }
+  return NULL;
+}
+
+/*
+ * find_start() - returns the index of the token starting at off in toks, or
+ *                -1 if none does
+ */
+int find_start(TokenBuf *toks, long off) {
+  int lo = 0;
+  int hi = toks->count;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (toks->off[mid] < off) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < toks->count && toks->off[lo] == off ? lo : -1;
+}
+
+/*
+ * splice_run() - appends tokens from index first of a chunk run to toks,
+ *                moving IDs into the scanner's pool in stream order so that
+ *                ids are numbered as the serial scanner numbers them
+ */
+void splice_run(Scanner *sc, ChunkScan *chunk, TokenBuf *run, int first,
+                TokenBuf *toks) {
+  int n = run->count - first;
+
+  tokbuf_reserve(toks, n);
+  memcpy(toks->kind + toks->count, run->kind + first, sizeof(uint8_t) * n);
+  memcpy(toks->off + toks->count, run->off + first, sizeof(uint32_t) * n);
+  memcpy(toks->len + toks->count, run->len + first, sizeof(uint32_t) * n);
+  memcpy(toks->val + toks->count, run->val + first, sizeof(int32_t) * n);
+
+  for (int i = toks->count; i < toks->count + n; i++) {
+    if (toks->kind[i] != ID) {
+      continue;
+    }
+    int id = toks->val[i];
+    if (chunk->idmap[id] < 0) {
+      chunk->idmap[id] =
+          intern(&sc->ids, sc->buf + toks->off[i], toks->len[i]);
+    }
+    toks->val[i] = chunk->idmap[id];
+  }
+  toks->count += n;
+}
+
+/*
+ * stitch() - rebuilds the serial token stream.  The scanner itself scans from
+ *            the end of what has been stitched so far until it reaches a
+ *            token start that a run of the chunk holding it also has; the
+ *            rest of that run is then taken whole, continuing into run 0
+ *            where run 1 joined it.
+ */
+void stitch(Scanner *sc, ChunkScan *chunks, int nchunks, long chunklen,
+            TokenBuf *toks) {
+  int next = 0; /* first chunk not yet stitched */
+
+  sc->pos = 0;
+  for (;;) {
+    int off, len;
+    int toke = scan_token(sc, &off, &len);
+
+    int c = toke == EOF ? nchunks : off / chunklen;
+    if (c >= nchunks) {
+      c = nchunks - 1;
+    }
+    if (toke != EOF && c >= next) {
+      for (int r = 0; r < 2; r++) {
+        int first = find_start(&chunks[c].run[r], off);
+        if (first < 0) {
+          continue;
+        }
+        splice_run(sc, &chunks[c], &chunks[c].run[r], first, toks);
+        if (r == 1 && chunks[c].join >= 0) {
+          splice_run(sc, &chunks[c], &chunks[c].run[0], chunks[c].join, toks);
+        }
+        // resume after the last token taken, which is in toks either way
+        int last = toks->count - 1;
+        sc->pos = toks->off[last] + toks->len[last];
+        next = c + 1;
+        break;
+      }
+      if (next == c + 1) {
+        continue;
+      }
+    }
+
+    tokbuf_reserve(toks, 1);
+    int i = toks->count++;
+    toks->kind[i] = toke == EOF ? TOK_EOF : toke;
+    toks->off[i] = off;
+    toks->len[i] = len;
+    toks->val[i] = toke == ID ? sc->tok_id : sc->lval;
+    if (toke == EOF) {
+      return;
+    }
+  }
+}
+
+int scan_all_parallel(Scanner *sc, TokenBuf *toks, int nthreads) {
+  if (nthreads <= 0) {
+    nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (sc->done || sc->pos != 0 || toks->count != 0 || nthreads < 2 ||
+      sc->len < 2 * PAR_MIN_CHUNK) {
+    return scan_all(sc, toks);
+  }
+
+  int nchunks = nthreads * PAR_CHUNKS_PER_THREAD;
+  long chunklen = (sc->len + nchunks - 1) / nchunks;
+  if (chunklen < PAR_MIN_CHUNK) {
+    chunklen = PAR_MIN_CHUNK;
+  }
+  nchunks = (sc->len + chunklen - 1) / chunklen;
+
+  ParJob job;
+  job.sc = sc;
+  job.nchunks = nchunks;
+  job.next = 0;
+  job.cmt_unclosed = unclosed_from(sc->buf, sc->len);
+  job.chunks = malloc(sizeof(ChunkScan) * nchunks);
+  for (int i = 0; i < nchunks; i++) {
+    job.chunks[i].start = i * chunklen;
+    job.chunks[i].end = i + 1 < nchunks ? (i + 1) * chunklen : sc->len;
+  }
+
+  if (nthreads > nchunks) {
+    nthreads = nchunks;
+  }
+  pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+  for (int i = 0; i < nthreads; i++) {
+    pthread_create(&threads[i], NULL, par_worker, &job);
+  }
+  for (int i = 0; i < nthreads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+
+  sc->cmt_unclosed = job.cmt_unclosed;
+  stitch(sc, job.chunks, nchunks, chunklen, toks);
+  sc->done = 1;
+
+  for (int i = 0; i < nchunks; i++) {
+    tokbuf_free(&job.chunks[i].run[0]);
+    tokbuf_free(&job.chunks[i].run[1]);
+    intern_free(&job.chunks[i].ids);
+    free(job.chunks[i].idmap);
+  }
+  free(job.chunks);
+  return toks->count;
+}
@@ -0,0 +1,258 @@
+/*
+ * Author: Edward Fattell
+ * File: scansimd.c
+ * Purpose: Scalar, SSE2 and AVX2 kernels for skipping whitespace, finding
+ *          the end of a comment and counting newlines, with runtime
+ *          selection by CPU feature detection
+ */
+#include "scansimd.h"
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*
+ * is_space() - the characters isspace() accepts in the C locale
+ */
+static int is_space(char ch) {
+  return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+/*******************************************************************************
+ *                                                                             *
+ *                                SCALAR KERNELS                               *
+ *                                                                             *
+ ******************************************************************************/
+
+static long skip_space_scalar(const char *buf, long pos, long end) {
+  while (pos < end && is_space(buf[pos])) {
+    pos++;
+  }
+  return pos;
+}
+
+static long find_cmt_close_scalar(const char *buf, long pos, long end) {
+  for (; pos + 1 < end; pos++) {
+    if (buf[pos] == '*' && buf[pos + 1] == '/') {
+      return pos;
+    }
+  }
+  return -1;
+}
+
+static long count_newlines_scalar(const char *buf, long pos, long end) {
+  long n = 0;
+
+  for (; pos < end; pos++) {
+    n += buf[pos] == '\n';
+  }
+  return n;
+}
+
+#ifdef HAVE_X86_SIMD
+
+/*******************************************************************************
+ *                                                                             *
+ *                                 SSE2 KERNELS                                *
+ *                                                                             *
+ ******************************************************************************/
+
+/*
+ * space_mask_sse2() - bit i is set when byte i of v is whitespace: a space,
+ *                     or '\t'..'\r', i.e. v - '\t' is at most 4 unsigned
+ */
+__attribute__((target("sse2"))) static inline int space_mask_sse2(__m128i v) {
+  __m128i ctl = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+  __m128i isctl = _mm_cmpeq_epi8(_mm_min_epu8(ctl, _mm_set1_epi8(4)), ctl);
+  __m128i issp = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  return _mm_movemask_epi8(_mm_or_si128(isctl, issp));
+}
+
+__attribute__((target("sse2"))) static long
+skip_space_sse2(const char *buf, long pos, long end) {
+  // runs between tokens are mostly a few bytes; vectors only pay off after
+  long stop = pos + 8 < end ? pos + 8 : end;
+  while (pos < stop && is_space(buf[pos])) {
+    pos++;
+  }
+  if (pos < stop) {
+    return pos;
+  }
+  for (; pos + 16 <= end; pos += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(buf + pos));
+    int other = ~space_mask_sse2(v) & 0xffff;
+    if (other) {
+      return pos + __builtin_ctz(other);
+    }
+  }
+  return skip_space_scalar(buf, pos, end);
+}
+
+__attribute__((target("sse2"))) static long
+find_cmt_close_sse2(const char *buf, long pos, long end) {
+  __m128i star = _mm_set1_epi8('*');
+  __m128i slash = _mm_set1_epi8('/');
+
+  // compare each byte and its successor, so a pair may straddle two blocks
+  for (; pos + 17 <= end; pos += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(buf + pos));
+    __m128i b = _mm_loadu_si128((const __m128i *)(buf + pos + 1));
+    int hit = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(a, star), _mm_cmpeq_epi8(b, slash)));
+    if (hit) {
+      return pos + __builtin_ctz(hit);
+    }
+  }
+  return find_cmt_close_scalar(buf, pos, end);
+}
+
+__attribute__((target("sse2"))) static long
+count_newlines_sse2(const char *buf, long pos, long end) {
+  __m128i nl = _mm_set1_epi8('\n');
+  long n = 0;
+
+  for (; pos + 16 <= end; pos += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(buf + pos));
+    n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+  }
+  return n + count_newlines_scalar(buf, pos, end);
+}
+
+/*******************************************************************************
+ *                                                                             *
+ *                                 AVX2 KERNELS                                *
+ *                                                                             *
+ ******************************************************************************/
+
+__attribute__((target("avx2"))) static inline unsigned
+space_mask_avx2(__m256i v) {
+  __m256i ctl = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+  __m256i isctl =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(ctl, _mm256_set1_epi8(4)), ctl);
+  __m256i issp = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+  return _mm256_movemask_epi8(_mm256_or_si256(isctl, issp));
+}
+
+__attribute__((target("avx2"))) static long
+skip_space_avx2(const char *buf, long pos, long end) {
+  long stop = pos + 8 < end ? pos + 8 : end;
+  while (pos < stop && is_space(buf[pos])) {
+    pos++;
+  }
+  if (pos < stop) {
+    return pos;
+  }
+  for (; pos + 32 <= end; pos += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(buf + pos));
+    unsigned other = ~space_mask_avx2(v);
+    if (other) {
+      return pos + __builtin_ctz(other);
+    }
+  }
+  return skip_space_sse2(buf, pos, end);
+}
+
+__attribute__((target("avx2"))) static long
+find_cmt_close_avx2(const char *buf, long pos, long end) {
+  __m256i star = _mm256_set1_epi8('*');
+  __m256i slash = _mm256_set1_epi8('/');
+
+  for (; pos + 33 <= end; pos += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(buf + pos));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(buf + pos + 1));
+    unsigned hit = _mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_cmpeq_epi8(a, star), _mm256_cmpeq_epi8(b, slash)));
+    if (hit) {
+      return pos + __builtin_ctz(hit);
+    }
+  }
+  return find_cmt_close_sse2(buf, pos, end);
+}
+
+__attribute__((target("avx2"))) static long
+count_newlines_avx2(const char *buf, long pos, long end) {
+  __m256i nl = _mm256_set1_epi8('\n');
+  long n = 0;
+
+  for (; pos + 32 <= end; pos += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(buf + pos));
+    n += __builtin_popcount(
+        (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)));
+  }
+  return n + count_newlines_sse2(buf, pos, end);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+/*******************************************************************************
+ *                                                                             *
+ *                                   DISPATCH                                  *
+ *                                                                             *
+ ******************************************************************************/
+
+long (*skip_space)(const char *buf, long pos, long end) = skip_space_scalar;
+long (*find_cmt_close)(const char *buf, long pos,
+                       long end) = find_cmt_close_scalar;
+long (*count_newlines)(const char *buf, long pos,
+                       long end) = count_newlines_scalar;
+
+/*
+ * supported() - whether the CPU can run kernels of the given level
+ */
+static int supported(SimdLevel level) {
+#ifdef HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (level == SIMD_AVX2) {
+    return __builtin_cpu_supports("avx2");
+  }
+  if (level == SIMD_SSE2) {
+    return __builtin_cpu_supports("sse2");
+  }
+#endif
+  return level == SIMD_SCALAR;
+}
+
+SimdLevel scan_simd_select(SimdLevel level) {
+  while (level > SIMD_SCALAR && !supported(level)) {
+    level--;
+  }
+
+  switch (level) {
+#ifdef HAVE_X86_SIMD
+  case SIMD_AVX2:
+    skip_space = skip_space_avx2;
+    find_cmt_close = find_cmt_close_avx2;
+    count_newlines = count_newlines_avx2;
+    break;
+  case SIMD_SSE2:
+    skip_space = skip_space_sse2;
+    find_cmt_close = find_cmt_close_sse2;
+    count_newlines = count_newlines_sse2;
+    break;
+#endif
+  default:
+    level = SIMD_SCALAR;
+    skip_space = skip_space_scalar;
+    find_cmt_close = find_cmt_close_scalar;
+    count_newlines = count_newlines_scalar;
+    break;
+  }
+  return level;
+}
+
+void scan_simd_init() {
+  scan_simd_select(SIMD_AVX2);
+}
+
+char *scan_simd_name(SimdLevel level) {
+  switch (level) {
+  case SIMD_AVX2:
+    return "avx2";
+  case SIMD_SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
@@ -0,0 +1,41 @@
+/*
+ * File: scansimd.h
+ * Author: Edward Fattell
+ * Purpose: Byte-scanning kernels used by the scanner to skip whitespace and
+ *          comments.  Each kernel has a scalar version and, on x86, SSE2 and
+ *          AVX2 versions; scan_simd_init() points the kernels at the best
+ *          one the CPU supports.
+ */
+
+#ifndef __SCANSIMD_H__
+#define __SCANSIMD_H__
+
+typedef enum { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 } SimdLevel;
+
+/*
+ * skip_space() returns the offset of the first byte in buf[pos, end) that is
+ * not whitespace, or end if there is none.
+ */
+extern long (*skip_space)(const char *buf, long pos, long end);
+
+/*
+ * find_cmt_close() returns the offset of the first star-slash pair that
+ * starts in buf[pos, end - 1), or -1 if there is none.
+ */
+extern long (*find_cmt_close)(const char *buf, long pos, long end);
+
+/*
+ * count_newlines() returns the number of '\n' bytes in buf[pos, end).
+ */
+extern long (*count_newlines)(const char *buf, long pos, long end);
+
+/*
+ * scan_simd_init() selects the fastest kernels the CPU supports.
+ * scan_simd_select() selects the kernels for a given level instead, falling
+ * back to the best supported level below it, and returns the level chosen.
+ */
+void scan_simd_init();
+SimdLevel scan_simd_select(SimdLevel level);
+char *scan_simd_name(SimdLevel level);
+
+#endif /* __SCANSIMD_H__ */
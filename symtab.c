@@ -0,0 +1,219 @@
+/*
+ * Author: Edward Fattell
+ * File: symtab.c
+ * Purpose: Scoped symbol table with open addressing and linear probing.
+ *          Deleting a name shifts later entries of its probe run back
+ *          instead of leaving a tombstone, so lookups never slow down as
+ *          scopes come and go.
+ */
+#include "symtab.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * home() - the slot a name hashes to; Fibonacci hashing of the pointer
+ */
+static int home(SymTab *tab, char *name) {
+  return ((uintptr_t)name * 0x9E3779B97F4A7C15ull) >> tab->shift;
+}
+
+/*
+ * find_slot() - the slot holding name, or the empty slot where it would go
+ */
+static int find_slot(SymTab *tab, char *name) {
+  int mask = tab->nslots - 1;
+  int i = home(tab, name);
+
+  while (tab->slots[i] != NULL && tab->slots[i]->name != name) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+static void alloc_slots(SymTab *tab, int nslots) {
+  tab->nslots = nslots;
+  tab->shift = 64;
+  while (nslots > 1) {
+    tab->shift--;
+    nslots >>= 1;
+  }
+  tab->slots = calloc(tab->nslots, sizeof(symboltab *));
+}
+
+void symtab_init(SymTab *tab) {
+  alloc_slots(tab, 256);
+  tab->count = 0;
+  tab->nentries = 0;
+  tab->capentries = 256;
+  tab->entries = malloc(sizeof(symboltab *) * tab->capentries);
+  tab->depth = 0;
+  tab->capmarks = 8;
+  tab->marks = malloc(sizeof(int) * tab->capmarks);
+  tab->retain = 0;
+  tab->popped = NULL;
+  tab->npopped = 0;
+  tab->cappopped = 0;
+}
+
+void symtab_free(SymTab *tab) {
+  for (int i = 0; i < tab->nentries; i++) {
+    free(tab->entries[i]);
+  }
+  for (int i = 0; i < tab->npopped; i++) {
+    free(tab->popped[i]);
+  }
+  free(tab->entries);
+  free(tab->slots);
+  free(tab->marks);
+  free(tab->popped);
+  tab->entries = NULL;
+  tab->popped = NULL;
+  tab->npopped = 0;
+  tab->slots = NULL;
+  tab->marks = NULL;
+  tab->nentries = 0;
+  tab->count = 0;
+  tab->depth = 0;
+}
+
+/*
+ * grow_slots() - doubles the table and reinserts every occupied slot
+ */
+static void grow_slots(SymTab *tab) {
+  symboltab **old = tab->slots;
+  int nold = tab->nslots;
+
+  alloc_slots(tab, nold * 2);
+  for (int i = 0; i < nold; i++) {
+    if (old[i] != NULL) {
+      tab->slots[find_slot(tab, old[i]->name)] = old[i];
+    }
+  }
+  free(old);
+}
+
+/*
+ * delete_slot() - empties slot i, moving back any later entry of the probe
+ *                 run that could no longer be reached
+ */
+static void delete_slot(SymTab *tab, int i) {
+  int mask = tab->nslots - 1;
+  int j = i;
+
+  for (;;) {
+    j = (j + 1) & mask;
+    if (tab->slots[j] == NULL) {
+      break;
+    }
+    // the entry at j can fill the hole at i unless its home lies
+    // cyclically in (i, j]
+    int k = home(tab, tab->slots[j]->name);
+    if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+      continue;
+    }
+    tab->slots[i] = tab->slots[j];
+    i = j;
+  }
+  tab->slots[i] = NULL;
+  tab->count--;
+}
+
+void symtab_push(SymTab *tab) {
+  if (tab->depth == tab->capmarks) {
+    tab->capmarks *= 2;
+    tab->marks = realloc(tab->marks, sizeof(int) * tab->capmarks);
+  }
+  tab->marks[tab->depth++] = tab->nentries;
+}
+
+void symtab_pop(SymTab *tab) {
+  int level = tab->depth;
+  int keep = tab->marks[level - 1];
+
+  for (int i = tab->marks[level - 1]; i < tab->nentries; i++) {
+    symboltab *entry = tab->entries[i];
+
+    // outer entries declared while the scope was open stay
+    if (entry->level != level) {
+      tab->entries[keep++] = entry;
+      continue;
+    }
+
+    int slot = find_slot(tab, entry->name);
+    if (tab->slots[slot] == entry) {
+      tab->slots[slot] = entry->shadow;
+      if (entry->shadow == NULL) {
+        delete_slot(tab, slot);
+      }
+    } else {
+      symboltab *outer = tab->slots[slot];
+      while (outer->shadow != entry) {
+        outer = outer->shadow;
+      }
+      outer->shadow = entry->shadow;
+    }
+
+    if (!tab->retain) {
+      free(entry);
+      continue;
+    }
+    if (tab->npopped == tab->cappopped) {
+      tab->cappopped = tab->cappopped ? tab->cappopped * 2 : 256;
+      tab->popped =
+          realloc(tab->popped, sizeof(symboltab *) * tab->cappopped);
+    }
+    tab->popped[tab->npopped++] = entry;
+  }
+
+  tab->nentries = keep;
+  tab->depth--;
+}
+
+symboltab *symtab_insert(SymTab *tab, char *name, int level) {
+  symboltab *entry = malloc(sizeof(symboltab));
+  entry->name = name;
+  entry->level = level;
+  entry->shadow = NULL;
+
+  if (tab->nentries == tab->capentries) {
+    tab->capentries *= 2;
+    tab->entries =
+        realloc(tab->entries, sizeof(symboltab *) * tab->capentries);
+  }
+  tab->entries[tab->nentries++] = entry;
+
+  int slot = find_slot(tab, name);
+  symboltab *inner = tab->slots[slot];
+  if (inner == NULL) {
+    tab->slots[slot] = entry;
+    tab->count++;
+    // keep the table at most half full
+    if (tab->count * 2 > tab->nslots) {
+      grow_slots(tab);
+    }
+  } else if (inner->level <= level) {
+    entry->shadow = inner;
+    tab->slots[slot] = entry;
+  } else {
+    // declared in an outer scope while an inner one is open
+    while (inner->shadow != NULL && inner->shadow->level > level) {
+      inner = inner->shadow;
+    }
+    entry->shadow = inner->shadow;
+    inner->shadow = entry;
+  }
+  return entry;
+}
+
+symboltab *symtab_lookup(SymTab *tab, char *name) {
+  return tab->slots[find_slot(tab, name)];
+}
+
+symboltab *symtab_lookup_at(SymTab *tab, char *name, int level) {
+  symboltab *entry = tab->slots[find_slot(tab, name)];
+
+  while (entry != NULL && entry->level > level) {
+    entry = entry->shadow;
+  }
+  return entry != NULL && entry->level == level ? entry : NULL;
+}
@@ -0,0 +1,58 @@
+/*
+ * File: symtab.h
+ * Author: Edward Fattell
+ * Purpose: Scoped symbol table.  Names are the scanner's interned handles, so
+ *          they are hashed and compared by pointer.  Each name's slot in an
+ *          open-addressed table holds its innermost entry, and each entry
+ *          points at the outer entry it shadows.
+ */
+
+#ifndef __SYMTAB_H__
+#define __SYMTAB_H__
+
+#include "parser.h"
+
+struct symtab {
+  symboltab **slots;    /* innermost entry for a name, NULL if empty */
+  int nslots;           /* size of slots, a power of two */
+  int shift;            /* 64 - log2(nslots), for hashing */
+  int count;            /* occupied slots */
+  symboltab **entries;  /* every entry, in the order declared */
+  int nentries;
+  int capentries;
+  int *marks;           /* nentries when each open scope was pushed */
+  int depth;            /* open scopes; 0 is the global scope */
+  int capmarks;
+  int retain;           /* if set, popped entries are kept until symtab_free */
+  symboltab **popped;
+  int npopped;
+  int cappopped;
+} typedef SymTab;
+
+void symtab_init(SymTab *tab);
+void symtab_free(SymTab *tab);
+
+/*
+ * symtab_push() opens a scope nested in the current one.  symtab_pop() closes
+ * it and frees its entries, uncovering the ones they shadowed; it costs time
+ * in the number of entries declared since the push.  When retain is set the
+ * entries are only unlinked, so trees that point at them stay valid.
+ */
+void symtab_push(SymTab *tab);
+void symtab_pop(SymTab *tab);
+
+/*
+ * symtab_insert() returns a new entry for name declared at scope level, 0
+ * being global.  It does not check for an earlier entry at that level.
+ */
+symboltab *symtab_insert(SymTab *tab, char *name, int level);
+
+/*
+ * symtab_lookup() returns the innermost entry for name, or NULL.
+ * symtab_lookup_at() returns the entry for name declared at scope level, or
+ * NULL if there is none.
+ */
+symboltab *symtab_lookup(SymTab *tab, char *name);
+symboltab *symtab_lookup_at(SymTab *tab, char *name, int level);
+
+#endif /* __SYMTAB_H__ */